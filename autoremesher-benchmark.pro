@@ -0,0 +1,43 @@
+QT -= core gui
+CONFIG += console release
+CONFIG -= app_bundle qt
+DEFINES += NDEBUG
+
+TARGET = autoremesher-benchmark
+
+OBJECTS_DIR=obj-benchmark
+
+CONFIG += c++14
+
+macx {
+	QMAKE_CXXFLAGS_RELEASE -= -O
+	QMAKE_CXXFLAGS_RELEASE -= -O1
+	QMAKE_CXXFLAGS_RELEASE -= -O2
+
+	QMAKE_CXXFLAGS_RELEASE += -O3
+}
+
+unix:!macx {
+	QMAKE_CXXFLAGS_RELEASE -= -O
+	QMAKE_CXXFLAGS_RELEASE -= -O1
+	QMAKE_CXXFLAGS_RELEASE -= -O2
+
+	QMAKE_CXXFLAGS_RELEASE += -O3
+}
+
+win32 {
+	QMAKE_CXXFLAGS += /O2
+	QMAKE_CXXFLAGS += /bigobj
+}
+
+DEFINES += _USE_MATH_DEFINES
+
+SOURCES += src/benchmark/main.cpp
+
+SOURCES += src/benchmark/syntheticmesh.cpp
+HEADERS += src/benchmark/syntheticmesh.h
+
+include(autoremesher.pri)
+
+target.path = ./
+INSTALLS += target
@@ -0,0 +1,40 @@
+QT -= core gui
+CONFIG += console release
+CONFIG -= app_bundle qt
+DEFINES += NDEBUG
+
+TARGET = autoremesher-cli
+
+OBJECTS_DIR=obj-cli
+
+CONFIG += c++14
+
+macx {
+	QMAKE_CXXFLAGS_RELEASE -= -O
+	QMAKE_CXXFLAGS_RELEASE -= -O1
+	QMAKE_CXXFLAGS_RELEASE -= -O2
+
+	QMAKE_CXXFLAGS_RELEASE += -O3
+}
+
+unix:!macx {
+	QMAKE_CXXFLAGS_RELEASE -= -O
+	QMAKE_CXXFLAGS_RELEASE -= -O1
+	QMAKE_CXXFLAGS_RELEASE -= -O2
+
+	QMAKE_CXXFLAGS_RELEASE += -O3
+}
+
+win32 {
+	QMAKE_CXXFLAGS += /O2
+	QMAKE_CXXFLAGS += /bigobj
+}
+
+DEFINES += _USE_MATH_DEFINES
+
+SOURCES += src/cli/main.cpp
+
+include(autoremesher.pri)
+
+target.path = ./
+INSTALLS += target
@@ -11,6 +11,7 @@ MOC_DIR=moc
 
 win32 {
 	RC_FILE = autoremesher.rc
+	LIBS += -lopengl32
 }
 
 macx {
@@ -91,8 +92,6 @@ INCLUDEPATH += thirdparty/QtWaitingSpinner
 SOURCES += thirdparty/QtWaitingSpinner/waitingspinnerwidget.cpp
 HEADERS += thirdparty/QtWaitingSpinner/waitingspinnerwidget.h
 
-INCLUDEPATH += include
-
 SOURCES += src/main.cpp
 
 SOURCES += src/logbrowser.cpp
@@ -154,147 +153,7 @@ HEADERS += src/ddsfile.h
 SOURCES += src/preferences.cpp
 HEADERS += src/preferences.h
 
-SOURCES += src/AutoRemesher/autoremesher.cpp
-HEADERS += src/AutoRemesher/autoremesher.h
-
-SOURCES += src/AutoRemesher/quadremesher.cpp
-HEADERS += src/AutoRemesher/quadremesher.h
-
-SOURCES += src/AutoRemesher/isotropicremesher.cpp
-HEADERS += src/AutoRemesher/isotropicremesher.h
-
-SOURCES += src/AutoRemesher/halfedge.cpp
-HEADERS += src/AutoRemesher/halfedge.h
-
-SOURCES += src/AutoRemesher/parameterizer.cpp
-HEADERS += src/AutoRemesher/parameterizer.h
-
-INCLUDEPATH += thirdparty/tbb/include
-unix {
-	LIBS += -Lthirdparty/tbb/build2 -ltbbmalloc_proxy_static -ltbbmalloc_static -ltbb_static
-	unix:!macx {
-		LIBS += -ldl
-	}
-}
-win32 {
-	LIBS += -Lthirdparty/tbb/build2/Release -ltbb_static -ltbbmalloc_static -ltbbmalloc_proxy_static
-}
-
-INCLUDEPATH += thirdparty/comiso
-INCLUDEPATH += thirdparty/comiso/Solver
-DEFINES += _SCL_SECURE_NO_DEPRECATE     #for comiso\ext\gmm-4.2\include\gmm\gmm_std.h
-DEFINES += INCLUDE_TEMPLATES
-INCLUDEPATH += thirdparty/comiso/CoMISo/ext/gmm-4.2/include
-INCLUDEPATH += thirdparty/libigl/include
-INCLUDEPATH += thirdparty/eigen
-
-SOURCES += thirdparty/comiso/CoMISo/Solver/EigenLDLTSolver.cc
-HEADERS += thirdparty/comiso/CoMISo/Solver/EigenLDLTSolver.hh
-
-SOURCES += thirdparty/comiso/CoMISo/Solver/MISolver.cc
-HEADERS += thirdparty/comiso/CoMISo/Solver/MISolver.hh
-
-SOURCES += thirdparty/comiso/CoMISo/Solver/ConstrainedSolver.cc
-HEADERS += thirdparty/comiso/CoMISo/Solver/ConstrainedSolver.hh
-
-SOURCES += thirdparty/comiso/CoMISo/Solver/IterativeSolverT.cc
-HEADERS += thirdparty/comiso/CoMISo/Solver/IterativeSolverT.hh
-
-SOURCES += thirdparty/comiso/CoMISo/Solver/GMM_Tools.cc
-HEADERS += thirdparty/comiso/CoMISo/Solver/GMM_Tools.hh
-
-INCLUDEPATH += thirdparty/OpenMesh/OpenMesh-8.1/src
-
-INCLUDEPATH += thirdparty/libQEx/src
-
-INCLUDEPATH += thirdparty/libQEx/interfaces/c
-
-HEADERS += thirdparty/libQEx/src/Algebra.hh
-
-HEADERS += thirdparty/libQEx/src/ExactPredicates.h
-
-HEADERS += thirdparty/libQEx/src/Globals.hh
-
-HEADERS += thirdparty/libQEx/src/MeshDecimatorT.hh
-
-SOURCES += thirdparty/libQEx/src/MeshExtractor.cc
-
-SOURCES += thirdparty/libQEx/src/MeshExtractorT.cc
-HEADERS += thirdparty/libQEx/src/MeshExtractorT.hh
-
-SOURCES += thirdparty/libQEx/src/predicates.c
-
-SOURCES += thirdparty/libQEx/src/QuadExtractorPostprocT.cc
-HEADERS += thirdparty/libQEx/src/QuadExtractorPostprocT.hh
-
-HEADERS += thirdparty/libQEx/src/TransitionFunction.hh
-
-HEADERS += thirdparty/libQEx/src/Vector.hh
-
-SOURCES += thirdparty/libQEx/interfaces/c/qex.cc
-HEADERS += thirdparty/libQEx/interfaces/c/qex.h
-
-LIBS += -Lthirdparty/OpenMesh/OpenMesh-8.1/build/Build/lib -lOpenMeshCore
-
-win32 {
-    LIBS += -luser32
-	LIBS += -lopengl32
-
-	isEmpty(BOOST_INCLUDEDIR) {
-		BOOST_INCLUDEDIR = $$(BOOST_INCLUDEDIR)
-	}
-	isEmpty(CGAL_DIR) {
-		CGAL_DIR = $$(CGAL_DIR)
-	}
-
-	isEmpty(BOOST_INCLUDEDIR) {
-		error("No BOOST_INCLUDEDIR define found in enviroment variables")
-	}
-
-	isEmpty(CGAL_DIR) {
-		error("No CGAL_DIR define found in enviroment variables")
-	}
-
-	GMP_LIBNAME = libgmp-10
-	MPFR_LIBNAME = libmpfr-4
-	CGAL_INCLUDEDIR = $$CGAL_DIR\include
-	GMP_INCLUDEDIR = $$CGAL_DIR\auxiliary\gmp\include
-	GMP_LIBDIR = $$CGAL_DIR\auxiliary\gmp\lib
-	MPFR_INCLUDEDIR = $$GMP_INCLUDEDIR
-	MPFR_LIBDIR = $$GMP_LIBDIR
-}
-
-macx {
-	GMP_LIBNAME = gmp
-	MPFR_LIBNAME = mpfr
-	BOOST_INCLUDEDIR = /usr/local/opt/boost/include
-	CGAL_INCLUDEDIR = /usr/local/opt/cgal/include
-	GMP_INCLUDEDIR = /usr/local/opt/gmp/include
-	GMP_LIBDIR = /usr/local/opt/gmp/lib
-	MPFR_INCLUDEDIR = /usr/local/opt/mpfr/include
-	MPFR_LIBDIR = /usr/local/opt/mpfr/lib
-}
-
-unix:!macx {
-	GMP_LIBNAME = gmp
-	MPFR_LIBNAME = mpfr
-	BOOST_INCLUDEDIR = /usr/local/include
-	CGAL_INCLUDEDIR = /usr/local/include
-	GMP_INCLUDEDIR = /usr/local/include
-	GMP_LIBDIR = /usr/local/lib
-	MPFR_INCLUDEDIR = /usr/local/include
-	MPFR_LIBDIR = /usr/local/lib
-}
-
-INCLUDEPATH += $$BOOST_INCLUDEDIR
-
-INCLUDEPATH += $$GMP_INCLUDEDIR
-LIBS += -L$$GMP_LIBDIR -l$$GMP_LIBNAME
-
-INCLUDEPATH += $$MPFR_INCLUDEDIR
-LIBS += -L$$MPFR_LIBDIR -l$$MPFR_LIBNAME
-
-INCLUDEPATH += $$CGAL_INCLUDEDIR
+include(autoremesher.pri)
 
 target.path = ./
 INSTALLS += target
\ No newline at end of file
@@ -0,0 +1,86 @@
+/*
+ *  Copyright (c) 2020 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+#ifndef AUTO_REMESHER_ARRAY_VIEW_H
+#define AUTO_REMESHER_ARRAY_VIEW_H
+#include <vector>
+#include <cstddef>
+
+namespace AutoRemesher
+{
+
+// Read only view over a contiguous buffer owned by the caller, so meshes can be handed over as flat
+// position and index arrays without copying them into per face containers first
+template <typename T>
+class ArrayView
+{
+public:
+    ArrayView() = default;
+    
+    ArrayView(const T *data, size_t size) :
+        m_data(data),
+        m_size(size)
+    {
+    }
+    
+    ArrayView(const std::vector<T> &vector) :
+        m_data(vector.data()),
+        m_size(vector.size())
+    {
+    }
+    
+    const T *data() const
+    {
+        return m_data;
+    }
+    
+    size_t size() const
+    {
+        return m_size;
+    }
+    
+    bool empty() const
+    {
+        return 0 == m_size;
+    }
+    
+    const T &operator[](size_t index) const
+    {
+        return m_data[index];
+    }
+    
+    const T *begin() const
+    {
+        return m_data;
+    }
+    
+    const T *end() const
+    {
+        return m_data + m_size;
+    }
+private:
+    const T *m_data = nullptr;
+    size_t m_size = 0;
+};
+
+}
+
+#endif
@@ -20,14 +20,27 @@
  *  SOFTWARE.
  */
 #include <unordered_set>
-#include <unordered_map>
+#include <atomic>
+#include <numeric>
+#include <algorithm>
 #include <AutoRemesher/AutoRemesher>
 #include <AutoRemesher/IsotropicRemesher>
 #include <AutoRemesher/HalfEdge>
 #include <AutoRemesher/Parameterizer>
+#include <AutoRemesher/MemoryUsage>
+#include <AutoRemesher/IslandCache>
+#include <AutoRemesher/PairingQuadRemesher>
+#include <AutoRemesher/RigidMatcher>
+#include <AutoRemesher/MirrorSymmetry>
+#include <AutoRemesher/Tracer>
 #include <tbb/parallel_for.h>
 #include <tbb/blocked_range.h>
 #include <tbb/tbb_thread.h>
+#include <tbb/task.h>
+#include <tbb/partitioner.h>
+#include <tbb/tick_count.h>
+#include <tbb/task_group.h>
+#include <tbb/parallel_sort.h>
 #if AUTO_REMESHER_DEBUG
 #include <QDebug>
 #endif
@@ -39,8 +52,24 @@ const double AutoRemesher::m_defaultTargetEdgeLength = 3.9;
 const double AutoRemesher::m_defaultConstraintRatio = 0.5;
 const size_t AutoRemesher::m_defaultMaxSingularityCount = 500;
 const size_t AutoRemesher::m_defaultMaxVertexCount = 8000;
+const size_t AutoRemesher::m_minIslandVertexCount = 100;
 const double AutoRemesher::m_defaultSharpEdgeDegrees = 60;
 const double AutoRemesher::m_defaultGradientSize = 170;
+const size_t AutoRemesher::m_maxPredictiveRemeshPasses = 3;
+const size_t AutoRemesher::m_maxFallbackRemeshPasses = 24;
+const double AutoRemesher::m_remeshedVertexCost = 4.0;
+const double AutoRemesher::m_boundaryVertexCost = 8.0;
+// Calibrate against the peak resident growth autoremesher-benchmark stages reports for a remesh, one case
+// per process on one thread so a single island is in flight, and a --triangles sweep to separate the part
+// that grows with the input from the part that grows with the target vertex count. Rounded up, an estimate
+// too low lets the budget be overrun while one too high only costs some parallelism
+const size_t AutoRemesher::m_bytesPerInputTriangle = 1024;
+const size_t AutoRemesher::m_bytesPerRemeshedVertex = 16 * 1024;
+// The uniform remesh stays alive while the sharp edge candidates of remeshCandidates, at 70, 80 and 90
+// degrees, run, each with its own remesh, half edge mesh and parameterizer
+const size_t AutoRemesher::m_remeshesInFlight = 4;
+const double AutoRemesher::m_instanceTolerance = 1e-3;
+const double AutoRemesher::m_symmetryTolerance = 1e-3;
     
 void AutoRemesher::buildEdgeToFaceMap(const std::vector<std::vector<size_t>> &triangles, std::map<std::pair<size_t, size_t>, size_t> &edgeToFaceMap)
 {
@@ -54,7 +83,14 @@ void AutoRemesher::buildEdgeToFaceMap(const std::vector<std::vector<size_t>> &tr
     }
 }
 
-void AutoRemesher::splitToIslands(const std::vector<std::vector<size_t>> &triangles, std::vector<std::vector<std::vector<size_t>>> &islands)
+void AutoRemesher::reportProgress(Stage stage, size_t islandIndex, double fraction) const
+{
+    std::lock_guard<std::mutex> lock(m_progressMutex);
+    if (m_progressCallback)
+        m_progressCallback(stage, islandIndex, fraction);
+}
+
+void AutoRemesher::splitToIslandsByEdgeMap(const std::vector<std::vector<size_t>> &triangles, std::vector<std::vector<std::vector<size_t>>> &islands)
 {
     std::map<std::pair<size_t, size_t>, size_t> edgeToFaceMap;
     buildEdgeToFaceMap(triangles, edgeToFaceMap);
@@ -88,6 +124,126 @@ void AutoRemesher::splitToIslands(const std::vector<std::vector<size_t>> &triang
     }
 }
 
+void AutoRemesher::splitToIslands(ArrayView<uint32_t> triangleIndices, 
+    std::vector<size_t> *islandFaces, 
+    std::vector<size_t> *islandOffsets)
+{
+    islandFaces->clear();
+    islandOffsets->assign(1, 0);
+    size_t triangleCount = triangleIndices.size() / 3;
+    if (0 == triangleCount)
+        return;
+    
+    // Each half edge keyed by its undirected edge, lower vertex in the high bits, sorting pairs it up with
+    // the half edges of the same edge
+    struct HalfEdgeRecord
+    {
+        uint64_t edge;
+        uint32_t face;
+        uint32_t forward;
+    };
+    std::vector<HalfEdgeRecord> records(triangleCount * 3);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, triangleCount), 
+            [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t faceIndex = range.begin(); faceIndex != range.end(); ++faceIndex) {
+            const uint32_t *face = &triangleIndices[faceIndex * 3];
+            for (size_t i = 0; i < 3; ++i) {
+                uint64_t from = face[i];
+                uint64_t to = face[(i + 1) % 3];
+                auto &record = records[faceIndex * 3 + i];
+                record.edge = from < to ? ((from << 32) | to) : ((to << 32) | from);
+                record.face = (uint32_t)faceIndex;
+                record.forward = from < to ? 1 : 0;
+            }
+        }
+    });
+    tbb::parallel_sort(records.begin(), records.end(), [](const HalfEdgeRecord &first, const HalfEdgeRecord &second) {
+        return first.edge < second.edge;
+    });
+    
+    // Lock free union find, a root is only ever hung under a lower root, so the root of a component
+    // is its lowest face index and concurrent unions can't form a cycle
+    std::vector<std::atomic<uint32_t>> parents(triangleCount);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, parents.size()), 
+            [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t i = range.begin(); i != range.end(); ++i)
+            parents[i].store((uint32_t)i);
+    });
+    auto findRoot = [&](uint32_t face) {
+        for (;;) {
+            uint32_t parent = parents[face].load();
+            if (parent == face)
+                return face;
+            uint32_t grandparent = parents[parent].load();
+            if (grandparent != parent)
+                parents[face].compare_exchange_weak(parent, grandparent);
+            face = grandparent;
+        }
+    };
+    auto unite = [&](uint32_t first, uint32_t second) {
+        for (;;) {
+            first = findRoot(first);
+            second = findRoot(second);
+            if (first == second)
+                return;
+            if (first < second)
+                std::swap(first, second);
+            uint32_t expected = first;
+            if (parents[first].compare_exchange_strong(expected, second))
+                return;
+        }
+    };
+    
+    // Faces are connected when they share an edge in opposite directions. Within a run of the same edge,
+    // linking every half edge to the first one of the other direction connects all of them
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, records.size()), 
+            [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t i = range.begin(); i != range.end(); ++i) {
+            if (0 != i && records[i - 1].edge == records[i].edge)
+                continue;
+            size_t end = i + 1;
+            while (end < records.size() && records[end].edge == records[i].edge)
+                ++end;
+            size_t firstForward = end;
+            size_t firstBackward = end;
+            for (size_t j = i; j < end; ++j) {
+                if (records[j].forward) {
+                    if (end == firstForward)
+                        firstForward = j;
+                } else if (end == firstBackward) {
+                    firstBackward = j;
+                }
+            }
+            if (end == firstForward || end == firstBackward)
+                continue;
+            for (size_t j = i; j < end; ++j)
+                unite(records[j].face, records[records[j].forward ? firstBackward : firstForward].face);
+        }
+    });
+    
+    // Islands are numbered by their lowest face, the same order the breadth first search discovered them
+    std::vector<uint32_t> faceIslands(triangleCount);
+    std::vector<size_t> islandSizes;
+    for (uint32_t face = 0; face < faceIslands.size(); ++face) {
+        uint32_t root = findRoot(face);
+        if (root == face) {
+            faceIslands[face] = (uint32_t)islandSizes.size();
+            islandSizes.push_back(0);
+        } else {
+            faceIslands[face] = faceIslands[root];
+        }
+        ++islandSizes[faceIslands[face]];
+    }
+    
+    islandOffsets->resize(islandSizes.size() + 1);
+    for (size_t i = 0; i < islandSizes.size(); ++i)
+        (*islandOffsets)[i + 1] = (*islandOffsets)[i] + islandSizes[i];
+    islandFaces->resize(triangleCount);
+    std::vector<size_t> fillPositions(islandOffsets->begin(), islandOffsets->end() - 1);
+    for (size_t face = 0; face < faceIslands.size(); ++face)
+        (*islandFaces)[fillPositions[faceIslands[face]]++] = face;
+}
+
 void AutoRemesher::calculateNormalizedFactors(const std::vector<Vector3> &vertices, Vector3 *origin, double *maxLength)
 {
     double minX = std::numeric_limits<double>::max();
@@ -127,27 +283,171 @@ void AutoRemesher::calculateNormalizedFactors(const std::vector<Vector3> &vertic
     };
 }
 
-IsotropicRemesher *AutoRemesher::createIsotropicRemesh(std::vector<Vector3> sourceVertices,
-    std::vector<std::vector<size_t>> sourceTriangles,
+double AutoRemesher::predictTargetEdgeLength(double area, size_t targetVertexCount)
+{
+    if (Double::isZero(area) || 0 == targetVertexCount)
+        return 0.0;
+    
+    // An isotropic triangulation with edge length L has faces of area sqrt(3)/4*L^2,
+    // and about twice as many faces as vertices, so V = 2*A/(sqrt(3)*L^2)
+    return std::sqrt(2.0 * area / (std::sqrt(3.0) * targetVertexCount));
+}
+
+double AutoRemesher::estimateIslandCost(ArrayView<Vector3> vertices,
+    ArrayView<uint32_t> triangleIndices,
+    size_t targetVertexCount)
+{
+    // Each half edge keyed by its undirected edge as in splitToIslands, sorted in a buffer each thread
+    // reuses across islands. An edge only seen in one direction is on the boundary
+    struct HalfEdgeRecord
+    {
+        uint64_t edge;
+        uint32_t forward;
+    };
+    static thread_local std::vector<HalfEdgeRecord> halfEdges;
+    halfEdges.clear();
+    halfEdges.reserve(triangleIndices.size());
+    double area = 0.0;
+    for (size_t k = 0; k + 2 < triangleIndices.size(); k += 3) {
+        const uint32_t *face = &triangleIndices[k];
+        area += 0.5 * Vector3::crossProduct(vertices[face[1]] - vertices[face[0]], 
+            vertices[face[2]] - vertices[face[0]]).length();
+        for (size_t i = 0; i < 3; ++i) {
+            uint64_t from = face[i];
+            uint64_t to = face[(i + 1) % 3];
+            halfEdges.push_back({from < to ? ((from << 32) | to) : ((to << 32) | from), from < to ? 1u : 0u});
+        }
+    }
+    std::sort(halfEdges.begin(), halfEdges.end(), [](const HalfEdgeRecord &first, const HalfEdgeRecord &second) {
+        return first.edge < second.edge;
+    });
+    double boundaryLength = 0.0;
+    for (size_t i = 0; i < halfEdges.size();) {
+        uint64_t edge = halfEdges[i].edge;
+        uint32_t directions = 0;
+        for (; i < halfEdges.size() && edge == halfEdges[i].edge; ++i)
+            directions |= 1u << halfEdges[i].forward;
+        if (3 != directions)
+            boundaryLength += (vertices[(uint32_t)(edge >> 32)] - vertices[(uint32_t)(edge & 0xffffffff)]).length();
+    }
+    
+    // Every island is remeshed to about the same vertex budget whatever its size, on top of that the
+    // input triangles feed the isotropic remesh, and the boundary vertices, spaced at the predicted
+    // edge length, each add a hard constraint to the parameterization
+    double boundaryVertexCount = 0.0;
+    double edgeLength = predictTargetEdgeLength(area, targetVertexCount);
+    if (!Double::isZero(edgeLength))
+        boundaryVertexCount = boundaryLength / edgeLength;
+    return triangleIndices.size() / 3 + 
+        m_remeshedVertexCost * targetVertexCount + 
+        m_boundaryVertexCost * boundaryVertexCount;
+}
+
+size_t AutoRemesher::estimateIslandMemory(size_t triangleCount, size_t targetVertexCount)
+{
+    // The input triangles are held by the island copy and the preprocessed mesh, the remeshed vertices
+    // once by every remesh in flight
+    return m_bytesPerInputTriangle * triangleCount + 
+        m_remeshesInFlight * m_bytesPerRemeshedVertex * targetVertexCount;
+}
+
+IsotropicRemesher *AutoRemesher::createIsotropicRemesh(const IsotropicRemesher::PreprocessedMesh *preprocessedMesh,
     double sharpEdgeDegrees, 
     size_t targetVertexCount,
-    double *targetEdgeLength)
+    double *targetEdgeLength,
+    EdgeLengthSearch edgeLengthSearch)
 {
     IsotropicRemesher *isotropicRemesher = nullptr;
     double minTargetVertexCount = targetVertexCount * 0.8;
     
+    auto remeshWithEdgeLength = [&](double edgeLength) {
+        IsotropicRemesher *remesher = new IsotropicRemesher(preprocessedMesh);
+        remesher->setSharpEdgeDegrees(sharpEdgeDegrees);
+        remesher->setTargetEdgeLength(edgeLength);
+        remesher->remesh();
+#if AUTO_REMESHER_DEBUG
+        qDebug() << "isotropicRemesher from vertices " << preprocessedMesh->vertexCount() << " to " << remesher->remeshedVertices().size() << " targetEdgeLength:" << edgeLength;
+#endif
+        return remesher;
+    };
+    
+    if (EdgeLengthSearch::Predictive == edgeLengthSearch) {
+        // Model the remeshed vertex count as V = c*L^-p, p starts from the ideal 2 and is refined
+        // by secant steps on the observed counts, bracketed so a bad fit can't run away
+        double idealTargetVertexCount = targetVertexCount * 0.9;
+        double edgeLength = *targetEdgeLength;
+        if (Double::isZero(edgeLength))
+            edgeLength = predictTargetEdgeLength(preprocessedMesh->area(), (size_t)idealTargetVertexCount);
+        if (Double::isZero(edgeLength))
+            edgeLength = m_defaultTargetEdgeLength;
+        double exponent = 2.0;
+        double lastEdgeLength = 0.0;
+        double lastVertexCount = 0.0;
+        double tooShortEdgeLength = 0.0;
+        double tooLongEdgeLength = std::numeric_limits<double>::max();
+        for (size_t pass = 0; pass < m_maxPredictiveRemeshPasses; ++pass) {
+            IsotropicRemesher *remesher = remeshWithEdgeLength(edgeLength);
+            double vertexCount = remesher->remeshedVertices().size();
+            if (vertexCount <= targetVertexCount &&
+                    (nullptr == isotropicRemesher || vertexCount > isotropicRemesher->remeshedVertices().size())) {
+                delete isotropicRemesher;
+                isotropicRemesher = remesher;
+                *targetEdgeLength = edgeLength;
+            } else {
+                delete remesher;
+            }
+            if (vertexCount >= minTargetVertexCount && vertexCount <= targetVertexCount)
+                break;
+            if (vertexCount > targetVertexCount)
+                tooShortEdgeLength = std::max(tooShortEdgeLength, edgeLength);
+            else
+                tooLongEdgeLength = std::min(tooLongEdgeLength, edgeLength);
+            if (vertexCount < 1.0) {
+                edgeLength *= 0.5;
+                continue;
+            }
+            if (lastVertexCount >= 1.0 && !Double::isEqual(lastVertexCount, vertexCount) &&
+                    !Double::isEqual(lastEdgeLength, edgeLength)) {
+                exponent = -std::log(vertexCount / lastVertexCount) / std::log(edgeLength / lastEdgeLength);
+                exponent = std::max(1.0, std::min(exponent, 3.0));
+            }
+            lastEdgeLength = edgeLength;
+            lastVertexCount = vertexCount;
+            edgeLength *= std::pow(vertexCount / idealTargetVertexCount, 1.0 / exponent);
+            if (edgeLength <= tooShortEdgeLength || edgeLength >= tooLongEdgeLength) {
+                if (tooShortEdgeLength > 0.0 && tooLongEdgeLength < std::numeric_limits<double>::max())
+                    edgeLength = std::sqrt(tooShortEdgeLength * tooLongEdgeLength);
+            }
+        }
+        if (nullptr != isotropicRemesher)
+            return isotropicRemesher;
+        
+        // Every pass overshot the vertex budget, keep growing the edge length like the iterative search does,
+        // a limited number of times, a degenerate island which never comes down keeps the smallest result
+        edgeLength = tooShortEdgeLength * 1.1;
+        for (size_t pass = 0; pass < m_maxFallbackRemeshPasses; ++pass) {
+            IsotropicRemesher *remesher = remeshWithEdgeLength(edgeLength);
+            if (nullptr == isotropicRemesher ||
+                    remesher->remeshedVertices().size() < isotropicRemesher->remeshedVertices().size()) {
+                delete isotropicRemesher;
+                isotropicRemesher = remesher;
+                *targetEdgeLength = edgeLength;
+            } else {
+                delete remesher;
+            }
+            if (isotropicRemesher->remeshedVertices().size() <= targetVertexCount)
+                break;
+            edgeLength *= 1.1;
+        }
+        return isotropicRemesher;
+    }
+    
     if (Double::isZero(*targetEdgeLength))
         *targetEdgeLength = m_defaultTargetEdgeLength;
     
     while (nullptr == isotropicRemesher || isotropicRemesher->remeshedVertices().size() < minTargetVertexCount) {
         delete isotropicRemesher;
-        isotropicRemesher = new IsotropicRemesher(sourceVertices, sourceTriangles);
-        isotropicRemesher->setSharpEdgeDegrees(sharpEdgeDegrees);
-        isotropicRemesher->setTargetEdgeLength(*targetEdgeLength);
-        isotropicRemesher->remesh();
-#if AUTO_REMESHER_DEBUG
-        qDebug() << "isotropicRemesher from vertices " << sourceVertices.size() << " to " << isotropicRemesher->remeshedVertices().size() << " targetEdgeLength:" << *targetEdgeLength;
-#endif
+        isotropicRemesher = remeshWithEdgeLength(*targetEdgeLength);
         *targetEdgeLength *= 0.9;
     }
     
@@ -156,13 +456,7 @@ IsotropicRemesher *AutoRemesher::createIsotropicRemesh(std::vector<Vector3> sour
 #if AUTO_REMESHER_DEBUG
         qDebug() << "isotropicRemesher remeshing targetEdgeLength:" << *targetEdgeLength;
 #endif
-        isotropicRemesher = new IsotropicRemesher(sourceVertices, sourceTriangles);
-        isotropicRemesher->setSharpEdgeDegrees(sharpEdgeDegrees);
-        isotropicRemesher->setTargetEdgeLength(*targetEdgeLength);
-        isotropicRemesher->remesh();
-#if AUTO_REMESHER_DEBUG
-        qDebug() << "isotropicRemesher from vertices " << sourceVertices.size() << " to " << isotropicRemesher->remeshedVertices().size() << " targetEdgeLength:" << *targetEdgeLength;
-#endif
+        isotropicRemesher = remeshWithEdgeLength(*targetEdgeLength);
         *targetEdgeLength *= 1.1;
     }
 
@@ -171,53 +465,93 @@ IsotropicRemesher *AutoRemesher::createIsotropicRemesh(std::vector<Vector3> sour
 
 bool AutoRemesher::remesh()
 {
+    reportProgress(Stage::Preprocessing, 0, 0.0);
+    
     Vector3 origin;
     double recoverScale = 1.0;
     double scale = 100;
     double maxLength = 1.0;
     calculateNormalizedFactors(m_vertices, &origin, &maxLength);
     recoverScale = maxLength / scale;
+    m_recoverScale = recoverScale;
     for (auto &v: m_vertices) {
         v = scale * (v - origin) / maxLength;
     }
     
-    std::vector<std::vector<std::vector<size_t>>> m_trianglesIslands;
-    splitToIslands(m_triangles, m_trianglesIslands);
+    std::vector<size_t> islandFaces;
+    std::vector<size_t> islandOffsets;
+    Tracer::ScopedEvent splitEvent("AutoRemesher::splitToIslands");
+    splitToIslands(m_triangleIndices, &islandFaces, &islandOffsets);
+    splitEvent.finish();
+    size_t islandCount = islandOffsets.size() - 1;
     
-    if (m_trianglesIslands.empty()) {
+    if (0 == islandCount) {
         std::cerr << "Input mesh is empty" << std::endl;
         return false;
     }
     
 #if AUTO_REMESHER_DEBUG
-    qDebug() << "Split to islands:" << m_trianglesIslands.size();
+    qDebug() << "Split to islands:" << islandCount;
 #endif
     
     struct IslandContext
     {
         std::vector<Vector3> vertices;
-        std::vector<std::vector<size_t>> triangles;
+        std::vector<uint32_t> triangleIndices;
         double gradientSize;
+        double area = 0.0;
+        size_t targetVertexCount = 0;
+        double estimatedCost = 0.0;
+        double seconds = 0.0;
+        double progress = 0.0;
+        size_t estimatedMemory = 0;
+        Vector3 origin;
+        bool cached = false;
+        bool tiny = false;
+        // The island this one is a congruent copy of, itself if none
+        size_t instanceSource = 0;
+        RigidMatcher::Transform instanceTransform;
+        // Only the positive half of the island is remeshed, the other half is its mirror image
+        bool mirrored = false;
+        MirrorSymmetry symmetry;
+        // The whole island, remeshed instead when the halves don't weld
+        std::vector<Vector3> wholeVertices;
+        std::vector<uint32_t> wholeTriangleIndices;
+        size_t wholeTargetVertexCount = 0;
+        // Results which don't come from a parameterization: read from the cache, paired for tiny islands,
+        // or completed by the mirror image for mirrored ones
+        std::vector<Vector3> remeshedVertices;
+        std::vector<uint32_t> remeshedQuadIndices;
+        IsotropicRemesher::PreprocessedMesh *preprocessedMesh = nullptr;
     };
 
+    // One remap array shared by all the islands, each island resets only the entries it touched,
+    // so extraction is a linear pass over the island faces
+    Tracer::ScopedEvent extractEvent("AutoRemesher::extractIslands");
+    const uint32_t unmappedVertex = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> oldToNewVertexMap(m_vertices.size(), unmappedVertex);
+    std::vector<uint32_t> islandVertices;
     std::vector<IslandContext> islandContexes;
-    islandContexes.reserve(m_trianglesIslands.size());
-    for (size_t islandIndex = 0; islandIndex < m_trianglesIslands.size(); ++islandIndex) {
-        const auto &island = m_trianglesIslands[islandIndex];
+    islandContexes.reserve(islandCount);
+    for (size_t islandIndex = 0; islandIndex < islandCount; ++islandIndex) {
         IslandContext context;
-        std::unordered_set<size_t> addedIndices;
-        std::unordered_map<size_t, size_t> oldToNewVertexMap;
-        for (const auto &face: island) {
-            std::vector<size_t> triangle;
+        islandVertices.clear();
+        context.triangleIndices.reserve((islandOffsets[islandIndex + 1] - islandOffsets[islandIndex]) * 3);
+        for (size_t k = islandOffsets[islandIndex]; k < islandOffsets[islandIndex + 1]; ++k) {
+            const uint32_t *face = &m_triangleIndices[islandFaces[k] * 3];
             for (size_t i = 0; i < 3; ++i) {
-                auto insertResult = addedIndices.insert(face[i]);
-                if (insertResult.second) {
-                    oldToNewVertexMap.insert({face[i], context.vertices.size()});
-                    context.vertices.push_back(m_vertices[face[i]]);
+                uint32_t &newIndex = oldToNewVertexMap[face[i]];
+                if (unmappedVertex == newIndex) {
+                    newIndex = (uint32_t)islandVertices.size();
+                    islandVertices.push_back(face[i]);
                 }
-                triangle.push_back(oldToNewVertexMap[face[i]]);
+                context.triangleIndices.push_back(newIndex);
             }
-            context.triangles.push_back(triangle);
+        }
+        context.vertices.reserve(islandVertices.size());
+        for (const auto &oldIndex: islandVertices) {
+            context.vertices.push_back(m_vertices[oldIndex]);
+            oldToNewVertexMap[oldIndex] = unmappedVertex;
         }
         
         double localMaxLength = 1.0;
@@ -225,13 +559,132 @@ bool AutoRemesher::remesh()
         calculateNormalizedFactors(context.vertices, &localOrigin, &localMaxLength);
         localMaxLength *= recoverScale;
         
+        context.origin = localOrigin;
+        context.instanceSource = islandIndex;
         context.gradientSize = m_gradientSize * (localMaxLength / maxLength);
+        for (size_t k = 0; k + 2 < context.triangleIndices.size(); k += 3) {
+            context.area += Vector3::area(context.vertices[context.triangleIndices[k]],
+                context.vertices[context.triangleIndices[k + 1]],
+                context.vertices[context.triangleIndices[k + 2]]);
+        }
+        
+        islandContexes.push_back(std::move(context));
+    }
+    extractEvent.finish();
+    
+    // With a total budget each island gets the share of its area, with a floor so a small part still
+    // resolves, otherwise every island gets the same budget whatever its size
+    double totalArea = 0.0;
+    for (const auto &context: islandContexes)
+        totalArea += context.area;
+    for (size_t islandIndex = 0; islandIndex < islandCount; ++islandIndex) {
+        auto &context = islandContexes[islandIndex];
+        context.targetVertexCount = m_targetVertexCount;
+        if (0 != m_totalVertexCount && totalArea > 0.0) {
+            context.targetVertexCount = std::max((size_t)std::llround(m_totalVertexCount * context.area / totalArea),
+                m_minIslandVertexCount);
+        }
+        context.estimatedCost = estimateIslandCost(context.vertices, context.triangleIndices, context.targetVertexCount);
+        context.estimatedMemory = estimateIslandMemory(context.triangleIndices.size() / 3, context.targetVertexCount);
         
 #if AUTO_REMESHER_DEBUG
-        qDebug() << "Gradient size[" << islandIndex << "/" << m_trianglesIslands.size() << "]:" << context.gradientSize;
+        qDebug() << "Gradient size[" << islandIndex << "/" << islandCount << "]:" << context.gradientSize << "target vertex count:" << context.targetVertexCount << "estimated cost:" << context.estimatedCost;
+#endif
+    }
+    
+    // Repeated parts are remeshed once. Islands are compared only within a signature group, the first island
+    // of a shape becomes its source and every later one which aligns to it within the tolerance copies it
+    m_instancedIslandCount = 0;
+    if (m_instancing && islandCount > 1) {
+        Tracer::ScopedEvent instancingEvent("AutoRemesher::matchInstances");
+        std::vector<std::vector<int64_t>> signatures(islandCount);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, islandCount), [&](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i != range.end(); ++i)
+                signatures[i] = RigidMatcher::signature(islandContexes[i].vertices, islandContexes[i].triangleIndices);
+        });
+        std::map<std::vector<int64_t>, std::vector<size_t>> signatureGroups;
+        for (size_t i = 0; i < islandCount; ++i)
+            signatureGroups[signatures[i]].push_back(i);
+        std::vector<const std::vector<size_t> *> groups;
+        for (const auto &it: signatureGroups) {
+            if (it.second.size() > 1)
+                groups.push_back(&it.second);
+        }
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, groups.size()), [&](const tbb::blocked_range<size_t> &range) {
+            for (size_t g = range.begin(); g != range.end(); ++g) {
+                std::vector<size_t> sources;
+                for (const auto &islandIndex: *groups[g]) {
+                    auto &context = islandContexes[islandIndex];
+                    double tolerance = std::max(m_instanceTolerance * RigidMatcher::radius(context.vertices), 1e-4);
+                    for (const auto &sourceIndex: sources) {
+                        const auto &source = islandContexes[sourceIndex];
+                        if (RigidMatcher::match(source.vertices, source.triangleIndices,
+                                context.vertices, context.triangleIndices, 
+                                tolerance, &context.instanceTransform)) {
+                            context.instanceSource = sourceIndex;
+                            break;
+                        }
+                    }
+                    if (islandIndex == context.instanceSource)
+                        sources.push_back(islandIndex);
+                }
+            }
+        });
+        for (size_t i = 0; i < islandCount; ++i) {
+            if (i != islandContexes[i].instanceSource) {
+                islandContexes[i].progress = 1.0;
+                ++m_instancedIslandCount;
+            }
+        }
+#if AUTO_REMESHER_DEBUG
+        qDebug() << "Instanced islands:" << m_instancedIslandCount << "/" << islandCount;
+#endif
+    }
+    
+    // After the instancing, which compares whole islands. A symmetric island is replaced by its positive half,
+    // the cut stays a protected boundary through the isotropic remesh, and the half gets half the vertex
+    // budget so the density is unchanged. The gradient size stays the one of the whole island
+    m_mirroredIslandCount = 0;
+    if (Symmetry::Off != m_symmetry) {
+        Tracer::ScopedEvent symmetryEvent("AutoRemesher::cutSymmetricIslands");
+        std::atomic<size_t> mirroredIslandCount(0);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, islandCount), [&](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i != range.end(); ++i) {
+                auto &context = islandContexes[i];
+                if (i != context.instanceSource || context.triangleIndices.size() / 3 < m_tinyIslandTriangleCount)
+                    continue;
+                double tolerance = std::max(m_symmetryTolerance * RigidMatcher::radius(context.vertices), 1e-4);
+                MirrorSymmetry symmetry;
+                if (Symmetry::Detect == m_symmetry) {
+                    if (!MirrorSymmetry::detect(context.vertices, tolerance, &symmetry))
+                        continue;
+                } else {
+                    Vector3 normal(Symmetry::X == m_symmetry ? 1.0 : 0.0,
+                        Symmetry::Y == m_symmetry ? 1.0 : 0.0,
+                        Symmetry::Z == m_symmetry ? 1.0 : 0.0);
+                    symmetry = MirrorSymmetry::throughCentroid(context.vertices, normal);
+                }
+                std::vector<Vector3> halfVertices;
+                std::vector<uint32_t> halfTriangleIndices;
+                if (!symmetry.cut(context.vertices, context.triangleIndices, tolerance, &halfVertices, &halfTriangleIndices))
+                    continue;
+                context.wholeVertices.swap(context.vertices);
+                context.wholeTriangleIndices.swap(context.triangleIndices);
+                context.wholeTargetVertexCount = context.targetVertexCount;
+                context.vertices.swap(halfVertices);
+                context.triangleIndices.swap(halfTriangleIndices);
+                context.mirrored = true;
+                context.symmetry = symmetry;
+                context.targetVertexCount = std::max(context.targetVertexCount / 2, (size_t)1);
+                context.estimatedCost = estimateIslandCost(context.vertices, context.triangleIndices, context.targetVertexCount);
+                context.estimatedMemory = estimateIslandMemory(context.triangleIndices.size() / 3, context.targetVertexCount);
+                ++mirroredIslandCount;
+            }
+        });
+        m_mirroredIslandCount = mirroredIslandCount;
+#if AUTO_REMESHER_DEBUG
+        qDebug() << "Mirrored islands:" << m_mirroredIslandCount << "/" << islandCount;
 #endif
-        
-        islandContexes.push_back(context);
     }
     
     class ParameterizationThread
@@ -253,7 +706,7 @@ bool AutoRemesher::remesh()
         }
         
         size_t islandIndex = 0;
-        const IslandContext *island = nullptr;
+        IslandContext *island = nullptr;
         IsotropicRemesher *isotropicRemesher = nullptr;
         Parameterizer *parameterizer = nullptr;
         HalfEdge::Mesh *mesh = nullptr;
@@ -261,211 +714,677 @@ bool AutoRemesher::remesh()
         double targetEdgeLength = m_defaultTargetEdgeLength;
         double limitRelativeHeight = 0.0;
         size_t singularityCount = 0;
+        bool cancelled = false;
+        // Only set once the singularity count has been measured, a candidate dropped by the
+        // cancelled task group before it started never gets here
+        bool ran = false;
         QuadRemesher *remesher = nullptr;
     };
 
-    std::vector<ParameterizationThread> parameterizationThreads(islandContexes.size());
-    for (size_t i = 0; i < islandContexes.size(); ++i) {
-        auto &thread = parameterizationThreads[i];
-        const auto &context = islandContexes[i];
-        thread.islandIndex = i;
-        thread.island = &context;
-    }
-
-    class UniformRemesher
+    class CandidateRemesher
     {
     public:
-        UniformRemesher(std::vector<ParameterizationThread> *parameterizationThreads) :
-            m_parameterizationThreads(parameterizationThreads)
+        CandidateRemesher(const AutoRemesher *autoRemesher,
+                std::vector<ParameterizationThread *> *candidates, size_t targetVertexCount,
+                EdgeLengthSearch edgeLengthSearch, ConstraintRatioSearch constraintRatioSearch,
+                tbb::task_group_context *speculativeContext) :
+            m_autoRemesher(autoRemesher),
+            m_candidates(candidates),
+            m_targetVertexCount(targetVertexCount),
+            m_edgeLengthSearch(edgeLengthSearch),
+            m_constraintRatioSearch(constraintRatioSearch),
+            m_speculativeContext(speculativeContext)
         {   
         }
-        void operator()(const tbb::blocked_range<size_t> &range) const
+        bool isCancelled() const
         {
-            for (size_t i = range.begin(); i != range.end(); ++i) {
-                auto &thread = (*m_parameterizationThreads)[i];
-                thread.targetEdgeLength = 0.0;
-                thread.isotropicRemesher = AutoRemesher::createIsotropicRemesh(thread.island->vertices,
-                    thread.island->triangles,
-                    m_defaultSharpEdgeDegrees, 
-                    m_defaultMaxVertexCount,
-                    &thread.targetEdgeLength);
-                    
-                thread.mesh = new HalfEdge::Mesh(thread.isotropicRemesher->remeshedVertices(), 
-                    thread.isotropicRemesher->remeshedTriangles());
-                
-                Parameterizer::Parameters parameters;
-                parameters.gradientSize = thread.island->gradientSize;
-
-                thread.parameterizer = new Parameterizer(thread.mesh, parameters);
-                thread.limitRelativeHeight = thread.parameterizer->calculateLimitRelativeHeight(m_defaultConstraintRatio);
-                thread.parameterizer->prepareConstraints(thread.limitRelativeHeight);
-                thread.parameterizer->miq(&thread.singularityCount, true);
-            }
-        }
-    private:
-        std::vector<ParameterizationThread> *m_parameterizationThreads = nullptr;
-    };
-    tbb::parallel_for(tbb::blocked_range<size_t>(0, parameterizationThreads.size()),
-        UniformRemesher(&parameterizationThreads));
-    std::vector<ParameterizationThread *> validParameterizationThreads;
-    std::vector<ParameterizationThread *> candidates;
-    for (size_t i = 0; i < parameterizationThreads.size(); ++i) {
-        auto &thread = parameterizationThreads[i];
-        if (thread.singularityCount <= m_defaultMaxSingularityCount) {
-#if AUTO_REMESHER_DEBUG
-            qDebug() << "Island[" << thread.islandIndex << "/" << islandContexes.size() << "]: has valid initial singularity count:" << thread.singularityCount;
-#endif
-            validParameterizationThreads.push_back(&thread);
-            continue;
-        }
-        
-        const double stepDegrees = 10.0;
-        for (double degrees = m_defaultSharpEdgeDegrees + stepDegrees; degrees <= 90.0; degrees += stepDegrees) {
-            ParameterizationThread *candidateThread = new ParameterizationThread;
-            candidateThread->sharpEdgeDegrees = degrees;
-            candidateThread->islandIndex = thread.islandIndex;
-            candidateThread->island = thread.island;
-            candidateThread->targetEdgeLength = thread.targetEdgeLength;
-            candidates.push_back(candidateThread);
-#if AUTO_REMESHER_DEBUG
-            qDebug() << "Island[" << thread.islandIndex << "/" << islandContexes.size() << "]: added candidate based on sharp edge degrees:" << degrees;
-#endif
-        }
-    }
-    
-    class CandidateRemesher
-    {
-    public:
-        CandidateRemesher(std::vector<ParameterizationThread *> *candidates) :
-            m_candidates(candidates)
-        {   
+            return m_autoRemesher->isCancelled() ||
+                (nullptr != m_speculativeContext && m_speculativeContext->is_group_execution_cancelled());
         }
         void operator()(const tbb::blocked_range<size_t> &range) const
         {
             for (size_t i = range.begin(); i != range.end(); ++i) {
                 auto &thread = *(*m_candidates)[i];
-                thread.targetEdgeLength = 0.0;
-                thread.isotropicRemesher = AutoRemesher::createIsotropicRemesh(thread.island->vertices,
-                    thread.island->triangles,
+                if (isCancelled()) {
+                    thread.cancelled = true;
+                    continue;
+                }
+                Tracer::ScopedIsland scopedIsland(thread.islandIndex);
+                Tracer::ScopedEvent event("AutoRemesher::remeshCandidate");
+                // The predictive search starts from the edge length the uniform pass settled on for this island
+                if (EdgeLengthSearch::Iterative == m_edgeLengthSearch)
+                    thread.targetEdgeLength = 0.0;
+                thread.isotropicRemesher = AutoRemesher::createIsotropicRemesh(thread.island->preprocessedMesh,
                     thread.sharpEdgeDegrees, 
-                    m_defaultMaxVertexCount,
-                    &thread.targetEdgeLength);
+                    m_targetVertexCount,
+                    &thread.targetEdgeLength,
+                    m_edgeLengthSearch);
                     
                 thread.mesh = new HalfEdge::Mesh(thread.isotropicRemesher->remeshedVertices(), 
-                    thread.isotropicRemesher->remeshedTriangles());
+                    thread.isotropicRemesher->remeshedTriangleIndices());
                 
                 Parameterizer::Parameters parameters;
                 parameters.gradientSize = thread.island->gradientSize;
+                parameters.symmetry = thread.island->mirrored ? &thread.island->symmetry : nullptr;
                 thread.parameterizer = new Parameterizer(thread.mesh, parameters);
                 
+                // The singularity count is roughly monotone in the constraint ratio, search for the largest
+                // ratio step which meets the threshold, from the highest ratio below the default one
                 const double stepConstraintRatio = m_defaultConstraintRatio * 0.05;
-                for (double constraintRadio = m_defaultConstraintRatio - stepConstraintRatio; 
-                        constraintRadio >= stepConstraintRatio; 
-                        constraintRadio -= stepConstraintRatio) {
+                const int maxStep = 19;
+                std::map<int, std::pair<double, size_t>> evaluatedSteps;
+                auto evaluate = [&](int step) {
+                    double constraintRadio = stepConstraintRatio * step;
                     thread.limitRelativeHeight = thread.parameterizer->calculateLimitRelativeHeight(constraintRadio);
                     thread.parameterizer->prepareConstraints(thread.limitRelativeHeight);
                     thread.parameterizer->miq(&thread.singularityCount, true);
+                    evaluatedSteps[step] = {thread.limitRelativeHeight, thread.singularityCount};
 #if AUTO_REMESHER_DEBUG
                     qDebug() << "Island[" << thread.islandIndex << "]: candidate(" << thread.sharpEdgeDegrees << ") calculated singularity count:" << thread.singularityCount << " on constraint ratio:" << constraintRadio;
 #endif
-                    if (thread.singularityCount <= m_defaultMaxSingularityCount) {
+                    return thread.singularityCount <= m_defaultMaxSingularityCount;
+                };
+                
+                int validStep = 0;
+                if (ConstraintRatioSearch::Linear == m_constraintRatioSearch) {
+                    for (int step = maxStep; step >= 1; --step) {
+                        if (isCancelled()) {
+                            thread.cancelled = true;
+                            break;
+                        }
+                        if (evaluate(step)) {
+                            validStep = step;
+                            break;
+                        }
+                    }
+                } else {
+                    // Gallop down from the highest step until one passes, then bisect between it and the last failed one
+                    int failedStep = maxStep + 1;
+                    int distance = 1;
+                    for (int step = maxStep; ; step = std::max(failedStep - distance, 1)) {
+                        if (isCancelled()) {
+                            thread.cancelled = true;
+                            break;
+                        }
+                        if (evaluate(step)) {
+                            validStep = step;
+                            break;
+                        }
+                        failedStep = step;
+                        if (1 == step)
+                            break;
+                        distance *= 2;
+                    }
+                    while (!thread.cancelled && 0 != validStep && failedStep - validStep > 1) {
+                        if (isCancelled()) {
+                            thread.cancelled = true;
+                            break;
+                        }
+                        int step = (validStep + failedStep) / 2;
+                        if (evaluate(step))
+                            validStep = step;
+                        else
+                            failedStep = step;
+                    }
+                }
+                if (thread.cancelled)
+                    continue;
+                
+                if (0 == validStep) {
+                    // None passed, the linear scan ends on the lowest ratio, otherwise take the fewest singularities seen
+                    validStep = evaluatedSteps.begin()->first;
+                    if (ConstraintRatioSearch::Linear != m_constraintRatioSearch) {
+                        for (const auto &it: evaluatedSteps) {
+                            if (it.second.second < evaluatedSteps[validStep].second)
+                                validStep = it.first;
+                        }
+                    }
+                }
+                thread.limitRelativeHeight = evaluatedSteps[validStep].first;
+                thread.singularityCount = evaluatedSteps[validStep].second;
+                thread.ran = true;
+                if (thread.singularityCount <= m_defaultMaxSingularityCount) {
 #if AUTO_REMESHER_DEBUG
-                        qDebug() << "Island[" << thread.islandIndex << "]: candidate(" << thread.sharpEdgeDegrees << ") found valid initial singularity count:" << thread.singularityCount;
+                    qDebug() << "Island[" << thread.islandIndex << "]: candidate(" << thread.sharpEdgeDegrees << ") found valid initial singularity count:" << thread.singularityCount;
 #endif
-                        break;
-                    }
+                    if (nullptr != m_speculativeContext)
+                        m_speculativeContext->cancel_group_execution();
                 }
             }
         }
     private:
+        const AutoRemesher *m_autoRemesher = nullptr;
         std::vector<ParameterizationThread *> *m_candidates = nullptr;
+        size_t m_targetVertexCount = 0;
+        EdgeLengthSearch m_edgeLengthSearch = EdgeLengthSearch::Predictive;
+        ConstraintRatioSearch m_constraintRatioSearch = ConstraintRatioSearch::Galloping;
+        tbb::task_group_context *m_speculativeContext = nullptr;
     };
-    tbb::parallel_for(tbb::blocked_range<size_t>(0, candidates.size()),
-        CandidateRemesher(&candidates));
-    
-    std::unordered_map<size_t, ParameterizationThread *> candidateMap;
-    for (size_t i = 0; i < candidates.size(); ++i) {
-        auto &thread = *candidates[i];
-        //if (thread.singularityCount > m_defaultMaxSingularityCount)
-        //    continue;
-        auto findCandidate = candidateMap.find(thread.islandIndex);
-        if (findCandidate == candidateMap.end()) {
-#if AUTO_REMESHER_DEBUG
-            qDebug() << "Island[" << thread.islandIndex << "/" << islandContexes.size() << "]: candidate(" << thread.sharpEdgeDegrees << ") chosen singularity count:" << thread.singularityCount;
-#endif
-            candidateMap.insert({thread.islandIndex, &thread});
-        } else {
-            if (thread.singularityCount < findCandidate->second->singularityCount) {
-#if AUTO_REMESHER_DEBUG
-                qDebug() << "Island[" << thread.islandIndex << "/" << islandContexes.size() << "]: candidate(" << thread.sharpEdgeDegrees << ") update singularity count to:" << thread.singularityCount;
-#endif
-                candidateMap[thread.islandIndex] = &thread;
+
+    // Each island runs through the whole pipeline on its own: uniform remesh, singularity check,
+    // candidates, parameterization and quad extraction, so one slow island no longer holds
+    // every other island back at a phase barrier
+    // Hands out the islands in cost order. With a memory budget, the next island is only admitted while
+    // the estimated footprint of the running ones leaves room for it, one larger than the whole budget
+    // is admitted once nothing else is running. Nothing ever waits here, finishing islands admit the next
+    class IslandQueue
+    {
+    public:
+        IslandQueue(const std::vector<IslandContext> *islandContexes, const std::vector<size_t> *islandOrder,
+                size_t memoryBudget) :
+            m_islandContexes(islandContexes),
+            m_islandOrder(islandOrder),
+            m_memoryBudget(memoryBudget)
+        {
+        }
+        size_t admit()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            size_t admittedCount = 0;
+            while (m_admittedCount < m_islandOrder->size()) {
+                size_t memory = (*m_islandContexes)[(*m_islandOrder)[m_admittedCount]].estimatedMemory;
+                if (0 != m_memoryBudget && m_usedMemory > 0 && m_usedMemory + memory > m_memoryBudget)
+                    break;
+                m_usedMemory += memory;
+                m_peakMemory = std::max(m_peakMemory, m_usedMemory);
+                ++m_admittedCount;
+                ++admittedCount;
             }
+            return admittedCount;
         }
-    }
-    
-    for (const auto &it: candidateMap)
-        validParameterizationThreads.push_back(it.second);
-    
-    class Miqer
+        size_t take()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return (*m_islandOrder)[m_takenCount++];
+        }
+        void release(size_t islandIndex)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_usedMemory -= (*m_islandContexes)[islandIndex].estimatedMemory;
+        }
+        size_t peakMemory() const
+        {
+            return m_peakMemory;
+        }
+    private:
+        const std::vector<IslandContext> *m_islandContexes = nullptr;
+        const std::vector<size_t> *m_islandOrder = nullptr;
+        size_t m_memoryBudget = 0;
+        size_t m_admittedCount = 0;
+        size_t m_takenCount = 0;
+        size_t m_usedMemory = 0;
+        size_t m_peakMemory = 0;
+        std::mutex m_mutex;
+    };
+
+    // Weighted by the estimated cost, so a finished bolt doesn't count as much as a finished body.
+    // Kept as running sums under the progress mutex, a report only adds its island's delta
+    struct IslandProgress
+    {
+        double totalCost = 0.0;
+        double doneCost = 0.0;
+    };
+
+    class IslandRemesher
     {
     public:
-        Miqer(std::vector<ParameterizationThread *> *validParameterizationThreads) :
-            m_validParameterizationThreads(validParameterizationThreads)
+        IslandRemesher(const AutoRemesher *autoRemesher, std::vector<IslandContext> *islandContexes,
+                IslandQueue *islandQueue, tbb::task_group *taskGroup,
+                std::vector<ParameterizationThread *> *results, IslandProgress *progress) :
+            m_autoRemesher(autoRemesher),
+            m_islandContexes(islandContexes),
+            m_islandQueue(islandQueue),
+            m_taskGroup(taskGroup),
+            m_results(results),
+            m_progress(progress)
+        {
+        }
+        void run() const
         {
+            for (size_t admittedCount = m_islandQueue->admit(); admittedCount > 0; --admittedCount)
+                m_taskGroup->run(*this);
+        }
+        void operator()() const
+        {
+            // Take the next admitted island off the cost sorted list rather than binding one to the task,
+            // whichever thread runs or steals this task, islands start strictly largest first
+            size_t islandIndex = m_islandQueue->take();
+            Tracer::ScopedIsland scopedIsland(islandIndex);
+            if (!m_autoRemesher->isCancelled()) {
+                tbb::tick_count startTime = tbb::tick_count::now();
+                if (!loadFromCache(islandIndex)) {
+                    (*m_results)[islandIndex] = remeshIsland(islandIndex);
+                    saveToCache(islandIndex);
+                }
+                (*m_islandContexes)[islandIndex].seconds = (tbb::tick_count::now() - startTime).seconds();
+            }
+            m_islandQueue->release(islandIndex);
+            if (!m_autoRemesher->isCancelled())
+                run();
+        }
+        void remeshTinyIsland(size_t islandIndex) const
+        {
+            Tracer::ScopedIsland scopedIsland(islandIndex);
+            auto &context = (*m_islandContexes)[islandIndex];
+            tbb::tick_count startTime = tbb::tick_count::now();
+            PairingQuadRemesher remesher(context.vertices, context.triangleIndices);
+            if (remesher.remesh()) {
+                context.remeshedVertices = remesher.remeshedVertices();
+                context.remeshedQuadIndices = remesher.remeshedQuadIndices();
+            }
+            context.seconds = (tbb::tick_count::now() - startTime).seconds();
+            reportIslandProgress(Stage::QuadExtracting, islandIndex, 1.0);
+        }
+    private:
+        uint64_t cacheKey(const IslandContext &context) const
+        {
+            // In the units of the input, relative to the island origin, so neither moving the part nor an edit
+            // elsewhere which changes the bounding box, and with it the normalization of the whole model, misses.
+            // Rounded on a power of two step about a millionth of the island size, which the float noise of
+            // the normalization doesn't cross. The gradient size of the island follows from the island and the
+            // model size, the one set by the user is hashed instead. Every other parameter the result depends on
+            // is hashed as well
+            uint64_t key = IslandCache::hash(&IslandCache::m_fileVersion, sizeof(IslandCache::m_fileVersion));
+            double recoverScale = m_autoRemesher->m_recoverScale;
+            double step = std::ldexp(1.0, std::ilogb(std::max(RigidMatcher::radius(context.vertices) * recoverScale, 
+                std::numeric_limits<double>::min())) - 20);
+            for (const auto &it: context.vertices) {
+                Vector3 position = (it - context.origin) * recoverScale;
+                for (size_t i = 0; i < 3; ++i) {
+                    int64_t rounded = (int64_t)std::round(position[i] / step);
+                    key = IslandCache::hash(&rounded, sizeof(rounded), key);
+                }
+            }
+            key = IslandCache::hash(context.triangleIndices.data(), 
+                context.triangleIndices.size() * sizeof(uint32_t), key);
+            double doubleParameters[] = {
+                m_autoRemesher->m_gradientSize,
+                m_defaultSharpEdgeDegrees,
+                m_defaultConstraintRatio
+            };
+            key = IslandCache::hash(doubleParameters, sizeof(doubleParameters), key);
+            uint64_t integerParameters[] = {
+                context.targetVertexCount,
+                m_defaultMaxSingularityCount,
+                (uint64_t)m_autoRemesher->m_edgeLengthSearch,
+                (uint64_t)m_autoRemesher->m_constraintRatioSearch,
+                (uint64_t)m_autoRemesher->m_speculativeCandidates
+            };
+            return IslandCache::hash(integerParameters, sizeof(integerParameters), key);
         }
         
-        void operator()(const tbb::blocked_range<size_t> &range) const
+        bool loadFromCache(size_t islandIndex) const
         {
-            for (size_t i = range.begin(); i != range.end(); ++i) {
-                auto &thread = *(*m_validParameterizationThreads)[i];
-                thread.parameterizer->prepareConstraints(thread.limitRelativeHeight);
+            if (m_autoRemesher->m_cacheDirectory.empty())
+                return false;
+            Tracer::ScopedEvent event("IslandCache::load");
+            auto &context = (*m_islandContexes)[islandIndex];
+            IslandCache islandCache(m_autoRemesher->m_cacheDirectory);
+            if (!islandCache.load(cacheKey(context), &context.remeshedVertices, &context.remeshedQuadIndices))
+                return false;
+            // Stored in the units of the input, relative to the island origin
+            for (auto &it: context.remeshedVertices)
+                it = it / m_autoRemesher->m_recoverScale + context.origin;
+            context.cached = true;
+#if AUTO_REMESHER_DEBUG
+            qDebug() << "Island[" << islandIndex << "/" << m_islandContexes->size() << "]: served from cache";
+#endif
+            reportIslandProgress(Stage::QuadExtracting, islandIndex, 1.0);
+            return true;
+        }
+        
+        void saveToCache(size_t islandIndex) const
+        {
+            if (m_autoRemesher->m_cacheDirectory.empty() || m_autoRemesher->isCancelled())
+                return;
+            Tracer::ScopedEvent event("IslandCache::save");
+            const auto &context = (*m_islandContexes)[islandIndex];
+            // Islands which failed to parameterize are stored as empty, they would fail again
+            std::vector<Vector3> vertices;
+            std::vector<uint32_t> quadIndices;
+            const ParameterizationThread *thread = (*m_results)[islandIndex];
+            if (nullptr != thread && nullptr != thread->remesher) {
+                for (const auto &it: thread->remesher->remeshedVertices())
+                    vertices.push_back((it - context.origin) * m_autoRemesher->m_recoverScale);
+                quadIndices = thread->remesher->remeshedQuadIndices();
+            }
+            IslandCache islandCache(m_autoRemesher->m_cacheDirectory);
+            if (!islandCache.save(cacheKey(context), vertices, quadIndices))
+                std::cerr << "Save island to cache failed: " << m_autoRemesher->m_cacheDirectory << std::endl;
+        }
+        
+        void reportIslandProgress(Stage stage, size_t islandIndex, double islandProgress) const
+        {
+            std::lock_guard<std::mutex> lock(m_autoRemesher->m_progressMutex);
+            auto &context = (*m_islandContexes)[islandIndex];
+            m_progress->doneCost += context.estimatedCost * (islandProgress - context.progress);
+            context.progress = islandProgress;
+            if (!m_autoRemesher->m_progressCallback)
+                return;
+            m_autoRemesher->m_progressCallback(stage, islandIndex, 
+                Double::isZero(m_progress->totalCost) ? 0.0 : std::min(m_progress->doneCost / m_progress->totalCost, 1.0));
+        }
+        
+        ParameterizationThread *remeshIsland(size_t islandIndex) const
+        {
+            auto &context = (*m_islandContexes)[islandIndex];
+            reportIslandProgress(Stage::UniformRemeshing, islandIndex, 0.0);
+            context.preprocessedMesh = new IsotropicRemesher::PreprocessedMesh(context.vertices,
+                context.triangleIndices);
+
+            ParameterizationThread *chosen = remeshUniform(islandIndex, &context);
+            if (m_autoRemesher->isCancelled()) {
+                delete chosen;
+                chosen = nullptr;
+            } else if (chosen->singularityCount <= m_defaultMaxSingularityCount) {
 #if AUTO_REMESHER_DEBUG
-                qDebug() << "Island[" << thread.islandIndex << "]: candidate(" << thread.sharpEdgeDegrees << ") parameterizing... on singularity count:" << thread.singularityCount;
+                qDebug() << "Island[" << islandIndex << "/" << m_islandContexes->size() << "]: has valid initial singularity count:" << chosen->singularityCount;
 #endif
-                if (!thread.parameterizer->miq(&thread.singularityCount, false)) {
+            } else {
+                reportIslandProgress(Stage::CandidateRemeshing, islandIndex, 0.35);
+                ParameterizationThread *candidate = remeshCandidates(*chosen);
+                delete chosen;
+                chosen = candidate;
+            }
+
+            delete context.preprocessedMesh;
+            context.preprocessedMesh = nullptr;
+
+            if (nullptr == chosen || m_autoRemesher->isCancelled()) {
+                delete chosen;
+                return nullptr;
+            }
+            reportIslandProgress(Stage::Parameterizing, islandIndex, 0.6);
+            parameterize(*chosen);
+            reportIslandProgress(Stage::QuadExtracting, islandIndex, 1.0);
+            return chosen;
+        }
+
+        ParameterizationThread *remeshUniform(size_t islandIndex, IslandContext *context) const
+        {
+            Tracer::ScopedEvent event("AutoRemesher::remeshUniform");
+            ParameterizationThread *thread = new ParameterizationThread;
+            thread->islandIndex = islandIndex;
+            thread->island = context;
+            thread->targetEdgeLength = 0.0;
+            thread->isotropicRemesher = AutoRemesher::createIsotropicRemesh(context->preprocessedMesh,
+                m_defaultSharpEdgeDegrees,
+                context->targetVertexCount,
+                &thread->targetEdgeLength,
+                m_autoRemesher->m_edgeLengthSearch);
+            if (m_autoRemesher->isCancelled())
+                return thread;
+
+            thread->mesh = new HalfEdge::Mesh(thread->isotropicRemesher->remeshedVertices(),
+                thread->isotropicRemesher->remeshedTriangleIndices());
+
+            Parameterizer::Parameters parameters;
+            parameters.gradientSize = context->gradientSize;
+            parameters.symmetry = context->mirrored ? &context->symmetry : nullptr;
+
+            thread->parameterizer = new Parameterizer(thread->mesh, parameters);
+            thread->limitRelativeHeight = thread->parameterizer->calculateLimitRelativeHeight(m_defaultConstraintRatio);
+            thread->parameterizer->prepareConstraints(thread->limitRelativeHeight);
+            thread->parameterizer->miq(&thread->singularityCount, true);
+            thread->ran = true;
+            return thread;
+        }
+
+        ParameterizationThread *remeshCandidates(const ParameterizationThread &uniform) const
+        {
+            Tracer::ScopedEvent event("AutoRemesher::remeshCandidates");
+            // Candidates are added in the order of preference, the closer to the default sharp edge degrees the better
+            std::vector<ParameterizationThread *> candidates;
+            const double stepDegrees = 10.0;
+            for (double degrees = m_defaultSharpEdgeDegrees + stepDegrees; degrees <= 90.0; degrees += stepDegrees) {
+                ParameterizationThread *candidateThread = new ParameterizationThread;
+                candidateThread->sharpEdgeDegrees = degrees;
+                candidateThread->islandIndex = uniform.islandIndex;
+                candidateThread->island = uniform.island;
+                candidateThread->targetEdgeLength = uniform.targetEdgeLength;
+                candidates.push_back(candidateThread);
 #if AUTO_REMESHER_DEBUG
-                    qDebug() << "Island[" << thread.islandIndex << "]: candidate(" << thread.sharpEdgeDegrees << ") parameterize failed on singularity count:" << thread.singularityCount;
+                qDebug() << "Island[" << uniform.islandIndex << "/" << m_islandContexes->size() << "]: added candidate based on sharp edge degrees:" << degrees;
 #endif
+            }
+
+            // The candidates run in a task group of their own, so a candidate which reaches
+            // the singularity threshold can cancel its siblings without touching other islands
+            bool speculativeCandidates = m_autoRemesher->m_speculativeCandidates;
+            tbb::task_group_context speculativeContext;
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, candidates.size(), 1),
+                CandidateRemesher(m_autoRemesher, &candidates, uniform.island->targetVertexCount,
+                    m_autoRemesher->m_edgeLengthSearch, m_autoRemesher->m_constraintRatioSearch,
+                    speculativeCandidates ? &speculativeContext : nullptr),
+                tbb::simple_partitioner(),
+                speculativeContext);
+
+            ParameterizationThread *chosen = nullptr;
+            for (const auto &thread: candidates) {
+                if (thread->cancelled || !thread->ran || nullptr == thread->parameterizer)
                     continue;
+                if (speculativeCandidates && thread->singularityCount <= m_defaultMaxSingularityCount) {
+                    chosen = thread;
+                    break;
                 }
+                if (nullptr == chosen || thread->singularityCount < chosen->singularityCount)
+                    chosen = thread;
+            }
+            for (auto &thread: candidates) {
+                if (thread != chosen)
+                    delete thread;
+            }
+#if AUTO_REMESHER_DEBUG
+            if (nullptr != chosen)
+                qDebug() << "Island[" << chosen->islandIndex << "/" << m_islandContexes->size() << "]: candidate(" << chosen->sharpEdgeDegrees << ") chosen singularity count:" << chosen->singularityCount;
+#endif
+            return chosen;
+        }
+
+        void parameterize(ParameterizationThread &thread) const
+        {
+            Tracer::ScopedEvent event("AutoRemesher::parameterize");
+            thread.parameterizer->prepareConstraints(thread.limitRelativeHeight);
 #if AUTO_REMESHER_DEBUG
-                qDebug() << "Island[" << thread.islandIndex << "]: candidate(" << thread.sharpEdgeDegrees << ") parameterize succeed on singularity count:" << thread.singularityCount;
+            qDebug() << "Island[" << thread.islandIndex << "]: candidate(" << thread.sharpEdgeDegrees << ") parameterizing... on singularity count:" << thread.singularityCount;
 #endif
-                thread.remesher = new QuadRemesher(thread.mesh);
-                thread.remesher->remesh();
+            if (!thread.parameterizer->miq(&thread.singularityCount, false)) {
+#if AUTO_REMESHER_DEBUG
+                qDebug() << "Island[" << thread.islandIndex << "]: candidate(" << thread.sharpEdgeDegrees << ") parameterize failed on singularity count:" << thread.singularityCount;
+#endif
+                return;
             }
+#if AUTO_REMESHER_DEBUG
+            qDebug() << "Island[" << thread.islandIndex << "]: candidate(" << thread.sharpEdgeDegrees << ") parameterize succeed on singularity count:" << thread.singularityCount;
+#endif
+            if (m_autoRemesher->isCancelled())
+                return;
+            reportIslandProgress(Stage::QuadExtracting, thread.islandIndex, 0.85);
+            thread.remesher = new QuadRemesher(thread.mesh);
+            thread.remesher->remesh();
         }
-    private:
-        std::vector<ParameterizationThread *> *m_validParameterizationThreads = nullptr;
+
+        const AutoRemesher *m_autoRemesher = nullptr;
+        std::vector<IslandContext> *m_islandContexes = nullptr;
+        IslandQueue *m_islandQueue = nullptr;
+        tbb::task_group *m_taskGroup = nullptr;
+        std::vector<ParameterizationThread *> *m_results = nullptr;
+        IslandProgress *m_progress = nullptr;
     };
-    tbb::parallel_for(tbb::blocked_range<size_t>(0, validParameterizationThreads.size()),
-        Miqer(&validParameterizationThreads));
-        
-    for (size_t i = 0; i < validParameterizationThreads.size(); ++i) {
-        auto &thread = *validParameterizationThreads[i];
-        if (nullptr == thread.remesher)
+
+    // Longest processing time first, so a large island doesn't end up as the tail behind many small ones
+    std::vector<size_t> islandOrder;
+    std::vector<size_t> tinyIslands;
+    for (size_t i = 0; i < islandContexes.size(); ++i) {
+        auto &context = islandContexes[i];
+        if (i != context.instanceSource)
             continue;
-        const auto &quads = thread.remesher->remeshedQuads();
-        if (quads.empty())
+        context.tiny = context.triangleIndices.size() / 3 < m_tinyIslandTriangleCount;
+        (context.tiny ? tinyIslands : islandOrder).push_back(i);
+    }
+    std::stable_sort(islandOrder.begin(), islandOrder.end(), [&](size_t first, size_t second) {
+        return islandContexes[first].estimatedCost > islandContexes[second].estimatedCost;
+    });
+    
+    IslandProgress islandProgress;
+    for (const auto &it: islandContexes) {
+        islandProgress.totalCost += it.estimatedCost;
+        islandProgress.doneCost += it.estimatedCost * it.progress;
+    }
+    
+    // Results are kept per island and merged in island order, whichever island finishes first
+    std::vector<ParameterizationThread *> islandResults(islandContexes.size(), nullptr);
+    IslandQueue islandQueue(&islandContexes, &islandOrder, m_memoryBudget);
+    tbb::task_group taskGroup;
+    IslandRemesher islandRemesher(this, &islandContexes, &islandQueue, &taskGroup, &islandResults, &islandProgress);
+    islandRemesher.run();
+    // Tiny islands take far less than a task's worth of work each, they go in batches and fill
+    // the gaps the large islands leave
+    if (!tinyIslands.empty()) {
+        taskGroup.run([&]() {
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, tinyIslands.size()), 
+                    [&](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i != range.end(); ++i) {
+                    if (isCancelled())
+                        return;
+                    islandRemesher.remeshTinyIsland(tinyIslands[i]);
+                }
+            });
+        });
+    }
+    taskGroup.wait();
+    m_peakEstimatedMemory = islandQueue.peakMemory();
+#if AUTO_REMESHER_DEBUG
+    qDebug() << "Peak estimated memory:" << m_peakEstimatedMemory << "bytes, budget:" << m_memoryBudget << "peak resident:" << MemoryUsage::peakResidentBytes();
+#endif
+    
+    if (isCancelled()) {
+        for (auto &it: islandResults)
+            delete it;
+#if AUTO_REMESHER_DEBUG
+        qDebug() << "Remesh cancelled";
+#endif
+        return false;
+    }
+    
+    m_islandTimings.clear();
+    islandOrder.insert(islandOrder.end(), tinyIslands.begin(), tinyIslands.end());
+    for (size_t i = 0; i < islandContexes.size(); ++i) {
+        if (i != islandContexes[i].instanceSource)
+            islandOrder.push_back(i);
+    }
+    for (const auto &islandIndex: islandOrder) {
+        const auto &context = islandContexes[islandIndex];
+        IslandTiming timing;
+        timing.islandIndex = islandIndex;
+        timing.triangleCount = context.triangleIndices.size() / 3;
+        timing.estimatedCost = context.estimatedCost;
+        timing.seconds = context.seconds;
+        m_islandTimings.push_back(timing);
+#if AUTO_REMESHER_DEBUG
+        qDebug() << "Island[" << islandIndex << "/" << islandContexes.size() << "]: estimated cost:" << context.estimatedCost << "seconds:" << context.seconds;
+#endif
+    }
+    
+    reportProgress(Stage::Merging, 0, 1.0);
+    Tracer::ScopedEvent mergeEvent("AutoRemesher::merge");
+    
+    // Mirrored halves are completed once, before their copies read them
+    std::vector<size_t> unweldedIslands;
+    std::mutex unweldedIslandsMutex;
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, islandContexes.size()), [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t i = range.begin(); i != range.end(); ++i) {
+            auto &context = islandContexes[i];
+            if (!context.mirrored)
+                continue;
+            if (!context.cached) {
+                const ParameterizationThread *thread = islandResults[i];
+                context.remeshedVertices.clear();
+                context.remeshedQuadIndices.clear();
+                if (nullptr != thread && nullptr != thread->remesher) {
+                    context.remeshedVertices = thread->remesher->remeshedVertices();
+                    context.remeshedQuadIndices = thread->remesher->remeshedQuadIndices();
+                }
+            }
+            // A half which failed to parameterize, or gave no quads, is remeshed whole as well
+            if (context.remeshedQuadIndices.empty() || 
+                    !context.symmetry.mirror(&context.remeshedVertices, &context.remeshedQuadIndices)) {
+                std::lock_guard<std::mutex> lock(unweldedIslandsMutex);
+                unweldedIslands.push_back(i);
+            }
+        }
+    });
+    
+    // A cracked seam is never emitted, those islands are remeshed whole, the same way as the others
+    if (!unweldedIslands.empty()) {
+        Tracer::ScopedEvent unweldedEvent("AutoRemesher::remeshUnweldedIslands");
+        std::sort(unweldedIslands.begin(), unweldedIslands.end());
+        for (const auto &i: unweldedIslands) {
+            auto &context = islandContexes[i];
+            context.vertices.swap(context.wholeVertices);
+            context.triangleIndices.swap(context.wholeTriangleIndices);
+            context.targetVertexCount = context.wholeTargetVertexCount;
+            islandProgress.totalCost -= context.estimatedCost;
+            islandProgress.doneCost -= context.estimatedCost * context.progress;
+            context.progress = 0.0;
+            context.estimatedCost = estimateIslandCost(context.vertices, context.triangleIndices, context.targetVertexCount);
+            islandProgress.totalCost += context.estimatedCost;
+            context.estimatedMemory = estimateIslandMemory(context.triangleIndices.size() / 3, context.targetVertexCount);
+            context.mirrored = false;
+            context.cached = false;
+            delete islandResults[i];
+            islandResults[i] = nullptr;
+#if AUTO_REMESHER_DEBUG
+            qDebug() << "Island[" << i << "/" << islandContexes.size() << "]: mirrored halves didn't weld, remeshing it whole";
+#endif
+        }
+        m_mirroredIslandCount -= unweldedIslands.size();
+        std::stable_sort(unweldedIslands.begin(), unweldedIslands.end(), [&](size_t first, size_t second) {
+            return islandContexes[first].estimatedCost > islandContexes[second].estimatedCost;
+        });
+        IslandQueue unweldedQueue(&islandContexes, &unweldedIslands, m_memoryBudget);
+        tbb::task_group unweldedTaskGroup;
+        IslandRemesher unweldedRemesher(this, &islandContexes, &unweldedQueue, &unweldedTaskGroup, &islandResults, &islandProgress);
+        unweldedRemesher.run();
+        unweldedTaskGroup.wait();
+        if (isCancelled()) {
+            for (auto &it: islandResults)
+                delete it;
+            return false;
+        }
+    }
+
+    m_cachedIslandCount = 0;
+    for (size_t i = 0; i < islandResults.size(); ++i) {
+        const std::vector<Vector3> *remeshedVertices = nullptr;
+        const std::vector<uint32_t> *remeshedQuadIndices = nullptr;
+        const auto &context = islandContexes[i];
+        size_t sourceIndex = context.instanceSource;
+        const auto &source = islandContexes[sourceIndex];
+        if (context.cached)
+            ++m_cachedIslandCount;
+        if (source.cached || source.tiny || source.mirrored) {
+            remeshedVertices = &source.remeshedVertices;
+            remeshedQuadIndices = &source.remeshedQuadIndices;
+        } else if (nullptr != islandResults[sourceIndex] && nullptr != islandResults[sourceIndex]->remesher) {
+            remeshedVertices = &islandResults[sourceIndex]->remesher->remeshedVertices();
+            remeshedQuadIndices = &islandResults[sourceIndex]->remesher->remeshedQuadIndices();
+        }
+        if (nullptr == remeshedQuadIndices || remeshedQuadIndices->empty())
             continue;
-        const auto &vertices = thread.remesher->remeshedVertices();
-        size_t vertexStartIndex = m_remeshedVertices.size();
+        const auto &vertices = *remeshedVertices;
+        uint32_t vertexStartIndex = (uint32_t)m_remeshedVertices.size();
         m_remeshedVertices.reserve(m_remeshedVertices.size() + vertices.size());
         for (const auto &it: vertices) {
-            m_remeshedVertices.push_back(it * recoverScale + origin);
-        }
-        for (const auto &it: quads) {
-            m_remeshedQuads.push_back({
-                vertexStartIndex + it[0], 
-                vertexStartIndex + it[1], 
-                vertexStartIndex + it[2], 
-                vertexStartIndex + it[3]
-            });
+            Vector3 position = sourceIndex == i ? it : context.instanceTransform.apply(it);
+            m_remeshedVertices.push_back(position * recoverScale + origin);
         }
+        m_remeshedQuadIndices.reserve(m_remeshedQuadIndices.size() + remeshedQuadIndices->size());
+        for (const auto &it: *remeshedQuadIndices)
+            m_remeshedQuadIndices.push_back(vertexStartIndex + it);
     }
-    
-    for (auto &it: candidates)
+
+    for (auto &it: islandResults)
         delete it;
     
 #if AUTO_REMESHER_DEBUG
@@ -23,23 +23,95 @@
 #define AUTO_REMESHER_AUTO_REMESHER_H
 #include <vector>
 #include <cstddef>
+#include <cstdint>
 #include <map>
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <string>
 #include <AutoRemesher/Vector3>
+#include <AutoRemesher/ArrayView>
 #include <AutoRemesher/QuadRemesher>
+#include <AutoRemesher/IsotropicRemesher>
+#include <AutoRemesher/MirrorSymmetry>
 
 namespace AutoRemesher
 {
-    
-class IsotropicRemesher;
 
 class AutoRemesher
 {
 public:
+    enum class EdgeLengthSearch
+    {
+        Iterative,
+        Predictive
+    };
+    
+    enum class ConstraintRatioSearch
+    {
+        Linear,
+        Galloping
+    };
+    
+    // Detect looks for a mirror plane on each island, X, Y and Z take the plane across that axis through
+    // the island center without checking it
+    enum class Symmetry
+    {
+        Off,
+        Detect,
+        X,
+        Y,
+        Z
+    };
+    
+    enum class Stage
+    {
+        Preprocessing,
+        UniformRemeshing,
+        CandidateRemeshing,
+        Parameterizing,
+        QuadExtracting,
+        Merging
+    };
+    
+    // Called from the worker threads, one call at a time, fraction is the progress of the whole remesh
+    // from 0 to 1. The island index is meaningless for Preprocessing and Merging
+    typedef std::function<void (Stage stage, size_t islandIndex, double fraction)> ProgressCallback;
+    
+    struct IslandTiming
+    {
+        size_t islandIndex = 0;
+        size_t triangleCount = 0;
+        double estimatedCost = 0.0;
+        double seconds = 0.0;
+    };
+    
+    // Positions as x, y, z triples and three indices per triangle, copied once into the remesher
+    AutoRemesher(ArrayView<double> positions,
+            ArrayView<uint32_t> triangleIndices) :
+        m_vertices(positions.size() / 3),
+        m_triangleIndices(triangleIndices.begin(), triangleIndices.end())
+    {
+        for (size_t i = 0, j = 0; i < m_vertices.size(); ++i, j += 3)
+            m_vertices[i] = Vector3(positions[j], positions[j + 1], positions[j + 2]);
+    }
+    
+    AutoRemesher(ArrayView<Vector3> vertices,
+            ArrayView<uint32_t> triangleIndices) :
+        m_vertices(vertices.begin(), vertices.end()),
+        m_triangleIndices(triangleIndices.begin(), triangleIndices.end())
+    {
+    }
+    
     AutoRemesher(const std::vector<Vector3> &vertices,
             const std::vector<std::vector<size_t>> &triangles) :
-        m_vertices(vertices),
-        m_triangles(triangles)
+        m_vertices(vertices)
     {
+        m_triangleIndices.reserve(triangles.size() * 3);
+        for (const auto &it: triangles) {
+            for (size_t i = 0; i < 3; ++i)
+                m_triangleIndices.push_back((uint32_t)it[i]);
+        }
     }
     
     void setGradientSize(double gradientSize)
@@ -47,43 +119,218 @@ public:
         m_gradientSize = gradientSize;
     }
     
+    void setTargetVertexCount(size_t targetVertexCount)
+    {
+        m_targetVertexCount = targetVertexCount;
+    }
+    
+    // Vertex budget of the whole model, shared out to the islands by their surface area, so the total work
+    // follows the budget whatever the island count. 0, the default, gives every island the target vertex count
+    void setTotalVertexCount(size_t totalVertexCount)
+    {
+        m_totalVertexCount = totalVertexCount;
+    }
+    
+    void setEdgeLengthSearch(EdgeLengthSearch edgeLengthSearch)
+    {
+        m_edgeLengthSearch = edgeLengthSearch;
+    }
+    
+    void setConstraintRatioSearch(ConstraintRatioSearch constraintRatioSearch)
+    {
+        m_constraintRatioSearch = constraintRatioSearch;
+    }
+    
+    // Off by default. When on, the first candidate under the singularity threshold cancels its
+    // siblings and the most preferred finished one is chosen instead of the one with the fewest
+    // singularities, so the result can depend on timing and the thread count
+    void setSpeculativeCandidates(bool speculativeCandidates)
+    {
+        m_speculativeCandidates = speculativeCandidates;
+    }
+    
+    // Bytes, islands are only started while their estimated footprint fits, 0 for no limit
+    void setMemoryBudget(size_t memoryBudget)
+    {
+        m_memoryBudget = memoryBudget;
+    }
+    
+    // Reuse the quads of islands remeshed before with the same parameters, empty to disable
+    void setCacheDirectory(const std::string &cacheDirectory)
+    {
+        m_cacheDirectory = cacheDirectory;
+    }
+    
+    // Islands with fewer triangles skip the parameterization, their triangles are paired into quads
+    // directly, in batches. 0, the default, sends every island through the full pipeline
+    void setTinyIslandTriangleCount(size_t tinyIslandTriangleCount)
+    {
+        m_tinyIslandTriangleCount = tinyIslandTriangleCount;
+    }
+    
+    // Islands which are rotated and moved copies of another island take its quads instead of being remeshed
+    void setInstancing(bool instancing)
+    {
+        m_instancing = instancing;
+    }
+    
+    // Symmetric islands are cut on their mirror plane, one half is remeshed and the quads are mirrored
+    // back, for half the cost and a symmetric topology. Off by default
+    void setSymmetry(Symmetry symmetry)
+    {
+        m_symmetry = symmetry;
+    }
+    
+    void setProgressCallback(ProgressCallback progressCallback)
+    {
+        m_progressCallback = progressCallback;
+    }
+    
+    // Once the token turns true, remesh() stops at the next stage or candidate step and returns false
+    void setCancelToken(const std::atomic<bool> *cancelToken)
+    {
+        m_cancelToken = cancelToken;
+    }
+    
+    bool isCancelled() const
+    {
+        return nullptr != m_cancelToken && *m_cancelToken;
+    }
+    
     const std::vector<Vector3> &remeshedVertices()
     {
         return m_remeshedVertices;
     }
     
+    // x, y, z triples of remeshedVertices(), without a copy
+    ArrayView<double> remeshedPositions()
+    {
+        static_assert(sizeof(Vector3) == 3 * sizeof(double), "Vector3 has to be three packed doubles");
+        if (m_remeshedVertices.empty())
+            return ArrayView<double>();
+        return ArrayView<double>(m_remeshedVertices[0].constData(), m_remeshedVertices.size() * 3);
+    }
+    
+    // Four indices per quad into remeshedVertices()
+    const std::vector<uint32_t> &remeshedQuadIndices()
+    {
+        return m_remeshedQuadIndices;
+    }
+    
+    // One list per quad, built from remeshedQuadIndices() on the first call
     const std::vector<std::vector<size_t>> &remeshedQuads()
     {
+        if (m_remeshedQuads.size() * 4 != m_remeshedQuadIndices.size()) {
+            m_remeshedQuads.clear();
+            m_remeshedQuads.reserve(m_remeshedQuadIndices.size() / 4);
+            for (size_t i = 0; i + 3 < m_remeshedQuadIndices.size(); i += 4) {
+                m_remeshedQuads.push_back({m_remeshedQuadIndices[i], m_remeshedQuadIndices[i + 1],
+                    m_remeshedQuadIndices[i + 2], m_remeshedQuadIndices[i + 3]});
+            }
+        }
         return m_remeshedQuads;
     }
     
+    // Estimated cost and measured time of each island from the last remesh, in the order the islands were started
+    const std::vector<IslandTiming> &islandTimings()
+    {
+        return m_islandTimings;
+    }
+    
+    // Highest sum of the estimated footprints of the islands running at once in the last remesh
+    size_t peakEstimatedMemory()
+    {
+        return m_peakEstimatedMemory;
+    }
+    
+    // Islands of the last remesh which were served from the cache
+    size_t cachedIslandCount()
+    {
+        return m_cachedIslandCount;
+    }
+    
+    // Islands of the last remesh which copied the quads of a congruent island
+    size_t instancedIslandCount()
+    {
+        return m_instancedIslandCount;
+    }
+    
+    // Islands of the last remesh which were remeshed as one half and mirrored
+    size_t mirroredIslandCount()
+    {
+        return m_mirroredIslandCount;
+    }
+    
     bool remesh();
     static void calculateNormalizedFactors(const std::vector<Vector3> &vertices, 
         Vector3 *origin, 
         double *maxLength);
-    static IsotropicRemesher *createIsotropicRemesh(std::vector<Vector3> sourceVertices,
-        std::vector<std::vector<size_t>> sourceTriangles,
+    static IsotropicRemesher *createIsotropicRemesh(const IsotropicRemesher::PreprocessedMesh *preprocessedMesh,
         double sharpEdgeDegrees, 
         size_t targetVertexCount,
-        double *targetEdgeLength);
+        double *targetEdgeLength,
+        EdgeLengthSearch edgeLengthSearch=EdgeLengthSearch::Predictive);
+    static double predictTargetEdgeLength(double area, size_t targetVertexCount);
+    static double estimateIslandCost(ArrayView<Vector3> vertices,
+        ArrayView<uint32_t> triangleIndices,
+        size_t targetVertexCount);
+    static size_t estimateIslandMemory(size_t triangleCount, size_t targetVertexCount);
+    // Faces of island i are islandFaces[islandOffsets[i]] until islandFaces[islandOffsets[i + 1]], islands in
+    // the order of their lowest face index
+    static void splitToIslands(ArrayView<uint32_t> triangleIndices, 
+        std::vector<size_t> *islandFaces, 
+        std::vector<size_t> *islandOffsets);
+    // The former map based version, kept to benchmark against
+    static void splitToIslandsByEdgeMap(const std::vector<std::vector<size_t>> &triangles, 
+        std::vector<std::vector<std::vector<size_t>>> &islands);
     
     static const double m_defaultTargetEdgeLength;
     static const double m_defaultConstraintRatio;
     static const size_t m_defaultMaxSingularityCount;
     static const size_t m_defaultMaxVertexCount;
+    static const size_t m_minIslandVertexCount;
     static const double m_defaultSharpEdgeDegrees;
     static const double m_defaultGradientSize;
+    static const size_t m_maxPredictiveRemeshPasses;
+    static const size_t m_maxFallbackRemeshPasses;
+    static const double m_remeshedVertexCost;
+    static const double m_boundaryVertexCost;
+    static const size_t m_bytesPerInputTriangle;
+    static const size_t m_bytesPerRemeshedVertex;
+    static const size_t m_remeshesInFlight;
+    static const double m_instanceTolerance;
+    static const double m_symmetryTolerance;
 private:
     std::vector<Vector3> m_vertices;
-    std::vector<std::vector<size_t>> m_triangles;
+    std::vector<uint32_t> m_triangleIndices;
     std::vector<Vector3> m_remeshedVertices;
+    std::vector<uint32_t> m_remeshedQuadIndices;
     std::vector<std::vector<size_t>> m_remeshedQuads;
+    std::vector<IslandTiming> m_islandTimings;
     double m_gradientSize = m_defaultGradientSize;
+    // From the normalized coordinates the islands are remeshed in back to the units of the input
+    double m_recoverScale = 1.0;
+    size_t m_targetVertexCount = m_defaultMaxVertexCount;
+    size_t m_totalVertexCount = 0;
+    EdgeLengthSearch m_edgeLengthSearch = EdgeLengthSearch::Predictive;
+    ConstraintRatioSearch m_constraintRatioSearch = ConstraintRatioSearch::Galloping;
+    bool m_speculativeCandidates = false;
+    size_t m_memoryBudget = 0;
+    size_t m_peakEstimatedMemory = 0;
+    std::string m_cacheDirectory;
+    size_t m_cachedIslandCount = 0;
+    size_t m_tinyIslandTriangleCount = 0;
+    bool m_instancing = true;
+    size_t m_instancedIslandCount = 0;
+    Symmetry m_symmetry = Symmetry::Off;
+    size_t m_mirroredIslandCount = 0;
+    ProgressCallback m_progressCallback;
+    const std::atomic<bool> *m_cancelToken = nullptr;
+    mutable std::mutex m_progressMutex;
     
-    void buildEdgeToFaceMap(const std::vector<std::vector<size_t>> &triangles, 
+    void reportProgress(Stage stage, size_t islandIndex, double fraction) const;
+    static void buildEdgeToFaceMap(const std::vector<std::vector<size_t>> &triangles, 
         std::map<std::pair<size_t, size_t>, size_t> &edgeToFaceMap);
-    void splitToIslands(const std::vector<std::vector<size_t>> &triangles, 
-        std::vector<std::vector<std::vector<size_t>>> &islands);
 };
     
 }
@@ -19,12 +19,17 @@
  *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  *  SOFTWARE.
  */
-#include <map>
+#include <atomic>
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <set>
 #include <AutoRemesher/HalfEdge>
 #include <AutoRemesher/Radians>
+#include <AutoRemesher/Tracer>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
+#include <tbb/blocked_range.h>
 #if AUTO_REMESHER_DEBUG
 #include <QDebug>
 #endif
@@ -35,73 +40,74 @@ namespace AutoRemesher
 namespace HalfEdge
 {
     
-inline void makeLinkedHalfEdges(HalfEdge *previous, HalfEdge *next) 
+inline void makeLinkedHalfEdges(std::vector<HalfEdge> &halfEdges, Index previous, Index next) 
 {
-    previous->nextHalfEdge = next;
-    next->previousHalfEdge = previous;
+    halfEdges[previous].nextHalfEdge = next;
+    halfEdges[next].previousHalfEdge = previous;
 }
 
-Mesh::Mesh(const std::vector<Vector3> &vertices,
-        const std::vector<std::vector<size_t>> &triangles)
+// Moves the kept elements down in place, newIndices maps every old index to the new one or InvalidIndex
+template <class T>
+static void compactElements(std::vector<T> &elements, std::vector<Index> *newIndices)
 {
-    std::vector<Vertex *> halfEdgeVertices(vertices.size());
-    for (size_t i = 0; i < vertices.size(); ++i) {
-        Vertex *vertex = allocVertex();
-        vertex->index = i;
-        vertex->position = vertices[i];
-        halfEdgeVertices[i] = vertex;
-    }
-    
-    std::vector<Face *> halfEdgeFaces(triangles.size());
-    for (size_t i = 0; i < triangles.size(); ++i) {
-        halfEdgeFaces[i] = allocFace();
+    newIndices->resize(elements.size());
+    Index keptCount = 0;
+    for (size_t i = 0; i < elements.size(); ++i) {
+        if (elements[i].removed) {
+            (*newIndices)[i] = InvalidIndex;
+            continue;
+        }
+        (*newIndices)[i] = keptCount;
+        if (keptCount != i)
+            elements[keptCount] = elements[i];
+        ++keptCount;
     }
+    elements.resize(keptCount);
+}
+
+inline Index remapIndex(const std::vector<Index> &newIndices, Index index)
+{
+    return InvalidIndex == index ? InvalidIndex : newIndices[index];
+}
+
+Mesh::Mesh(ArrayView<Vector3> vertices,
+        ArrayView<uint32_t> triangleIndices)
+{
+    Tracer::ScopedEvent event("HalfEdge::Mesh");
+    size_t triangleCount = triangleIndices.size() / 3;
+    m_vertices.resize(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i)
+        m_vertices[i].position = vertices[i];
     
-    std::map<std::pair<size_t, size_t>, HalfEdge *> halfEdgeIndexMap;
-    for (size_t i = 0; i < triangles.size(); ++i) {
-        auto &face = halfEdgeFaces[i];
-
-        const auto &triangleIndices = triangles[i];
-        std::vector<HalfEdge *> halfEdges = {
-            allocHalfEdge(),
-            allocHalfEdge(),
-            allocHalfEdge()
-        };
-        face->anyHalfEdge = halfEdges[0];
+    // The three half edges of face i are 3*i, 3*i+1 and 3*i+2
+    m_faces.resize(triangleCount);
+    m_halfEdges.resize(triangleCount * 3);
+    for (size_t i = 0; i < triangleCount; ++i) {
+        const uint32_t *triangle = &triangleIndices[i * 3];
+        Index firstHalfEdge = (Index)(i * 3);
+        m_faces[i].anyHalfEdge = firstHalfEdge;
         for (size_t j = 0; j < 3; ++j) {
             size_t k = (j + 1) % 3;
             size_t h = (k + 1) % 3;
-            auto &halfEdge = halfEdges[j];
-            const auto &vertexIndex = triangleIndices[j];
-            const auto &nextVertexIndex = triangleIndices[k];
-            auto &vertex = halfEdgeVertices[vertexIndex];
-            vertex->anyHalfEdge = halfEdge;
-            ++vertex->halfEdgeCount;
-            halfEdge->startVertex = vertex;
-            halfEdge->previousHalfEdge = halfEdges[h];
-            halfEdge->nextHalfEdge = halfEdges[k];
-            halfEdge->leftFace = face;
-            auto insertResult = halfEdgeIndexMap.insert({{vertexIndex, nextVertexIndex}, halfEdge});
-            if (!insertResult.second) {
-                std::cerr << "Found repeated halfedge" << std::endl;
-                ++m_repeatedHalfEdges;
-            }
-        }
-    }
-    for (auto &it: halfEdgeIndexMap) {
-        auto findOppositeResult = halfEdgeIndexMap.find({it.first.second, it.first.first});
-        if (findOppositeResult == halfEdgeIndexMap.end()) {
-            std::cerr << "Found alone halfedge" << std::endl;
-            ++m_aloneHalfEdges;
-            continue;
+            Index halfEdgeIndex = firstHalfEdge + (Index)j;
+            auto &halfEdge = m_halfEdges[halfEdgeIndex];
+            auto &vertex = m_vertices[triangle[j]];
+            vertex.anyHalfEdge = halfEdgeIndex;
+            ++vertex.halfEdgeCount;
+            halfEdge.startVertex = triangle[j];
+            halfEdge.previousHalfEdge = firstHalfEdge + (Index)h;
+            halfEdge.nextHalfEdge = firstHalfEdge + (Index)k;
+            halfEdge.leftFace = (Index)i;
         }
-        it.second->oppositeHalfEdge = findOppositeResult->second;
     }
+    linkOppositeHalfEdges(triangleIndices);
     
     if (isWatertight()) {
         removeZeroAngleTriangles();
     }
     
+    calculateVertexAdjacency();
+    
 #if AUTO_REMESHER_DEBUG
     qDebug() << "calculateFaceNormals";
 #endif
@@ -127,389 +133,494 @@ Mesh::Mesh(const std::vector<Vector3> &vertices,
 #endif
 }
 
-Mesh::~Mesh()
+void Mesh::linkOppositeHalfEdges(ArrayView<uint32_t> triangleIndices)
 {
-    while (nullptr != m_lastVertex)
-        freeVertex(m_lastVertex);
-    while (nullptr != m_lastFace)
-        freeFace(m_lastFace);
-    while (nullptr != m_lastHalfEdge)
-        freeHalfEdge(m_lastHalfEdge);
-    while (nullptr != m_firstDeferedRemovalVertex) {
-        auto vertex = m_firstDeferedRemovalVertex;
-        m_firstDeferedRemovalVertex = vertex->_next;
-        delete vertex;
-    }
-    while (nullptr != m_firstDeferedRemovalHalfEdge) {
-        auto halfEdge = m_firstDeferedRemovalHalfEdge;
-        m_firstDeferedRemovalHalfEdge = halfEdge->_next;
-        delete halfEdge;
-    }
-    while (nullptr != m_firstDeferedRemovalFace) {
-        auto face = m_firstDeferedRemovalFace;
-        m_firstDeferedRemovalFace = face->_next;
-        delete face;
+    // Each half edge keyed by its undirected edge, lower vertex in the high bits, and its direction. Sorting
+    // brings both directions of an edge together, the lowest half edge first within each direction
+    struct HalfEdgeRecord
+    {
+        uint64_t edge;
+        uint32_t halfEdge;
+        uint32_t forward;
+    };
+    std::vector<HalfEdgeRecord> records(m_halfEdges.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, records.size()), 
+            [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t i = range.begin(); i != range.end(); ++i) {
+            uint64_t from = triangleIndices[i];
+            uint64_t to = triangleIndices[i - i % 3 + (i + 1) % 3];
+            auto &record = records[i];
+            record.edge = from < to ? ((from << 32) | to) : ((to << 32) | from);
+            record.halfEdge = (uint32_t)i;
+            record.forward = from < to ? 1 : 0;
+        }
+    });
+    tbb::parallel_sort(records.begin(), records.end(), [](const HalfEdgeRecord &first, const HalfEdgeRecord &second) {
+        if (first.edge != second.edge)
+            return first.edge < second.edge;
+        if (first.forward != second.forward)
+            return first.forward > second.forward;
+        return first.halfEdge < second.halfEdge;
+    });
+    
+    // Within a run of the same edge, the first half edge of each direction is linked to the first one of the
+    // other direction. Further half edges of a direction are repeated ones and stay unlinked, a direction
+    // without the other one is a boundary
+    std::atomic<size_t> repeatedHalfEdges(0);
+    std::atomic<size_t> aloneHalfEdges(0);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, records.size()), 
+            [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t i = range.begin(); i != range.end(); ++i) {
+            if (0 != i && records[i - 1].edge == records[i].edge)
+                continue;
+            size_t end = i + 1;
+            while (end < records.size() && records[end].edge == records[i].edge)
+                ++end;
+            size_t backward = i;
+            while (backward < end && records[backward].forward)
+                ++backward;
+            size_t forwardCount = backward - i;
+            size_t backwardCount = end - backward;
+            if (forwardCount > 1)
+                repeatedHalfEdges += forwardCount - 1;
+            if (backwardCount > 1)
+                repeatedHalfEdges += backwardCount - 1;
+            if (0 == forwardCount || 0 == backwardCount) {
+                ++aloneHalfEdges;
+                continue;
+            }
+            m_halfEdges[records[i].halfEdge].oppositeHalfEdge = records[backward].halfEdge;
+            m_halfEdges[records[backward].halfEdge].oppositeHalfEdge = records[i].halfEdge;
+        }
+    });
+    m_repeatedHalfEdges = repeatedHalfEdges;
+    m_aloneHalfEdges = aloneHalfEdges;
+    
+    if (0 != m_repeatedHalfEdges)
+        std::cerr << "Found repeated halfedges: " << m_repeatedHalfEdges << std::endl;
+#if AUTO_REMESHER_DEBUG
+    if (0 != m_aloneHalfEdges)
+        qDebug() << "Found alone halfedges:" << m_aloneHalfEdges;
+#endif
+}
+
+Index Mesh::addVertex()
+{
+    m_vertices.push_back(Vertex());
+    return (Index)(m_vertices.size() - 1);
+}
+
+Index Mesh::addFace()
+{
+    m_faces.push_back(Face());
+    return (Index)(m_faces.size() - 1);
+}
+
+Index Mesh::addHalfEdge()
+{
+    m_halfEdges.push_back(HalfEdge());
+    return (Index)(m_halfEdges.size() - 1);
+}
+
+void Mesh::removeVertex(Index vertex)
+{
+    if (m_vertices[vertex].removed)
+        return;
+    m_vertices[vertex].removed = true;
+    ++m_removedVertexCount;
+}
+
+void Mesh::removeFace(Index face)
+{
+    if (m_faces[face].removed)
+        return;
+    m_faces[face].removed = true;
+    ++m_removedFaceCount;
+}
+
+void Mesh::removeHalfEdge(Index halfEdge)
+{
+    if (m_halfEdges[halfEdge].removed)
+        return;
+    m_halfEdges[halfEdge].removed = true;
+    m_halfEdges[halfEdge].leftFace = InvalidIndex;
+    ++m_removedHalfEdgeCount;
+}
+
+void Mesh::compact()
+{
+    if (0 == m_removedVertexCount && 0 == m_removedFaceCount && 0 == m_removedHalfEdgeCount)
+        return;
+    
+    std::vector<Index> newVertexIndices;
+    std::vector<Index> newFaceIndices;
+    std::vector<Index> newHalfEdgeIndices;
+    compactElements(m_vertices, &newVertexIndices);
+    compactElements(m_faces, &newFaceIndices);
+    compactElements(m_halfEdges, &newHalfEdgeIndices);
+    
+    for (auto &vertex: m_vertices)
+        vertex.anyHalfEdge = remapIndex(newHalfEdgeIndices, vertex.anyHalfEdge);
+    for (auto &face: m_faces)
+        face.anyHalfEdge = remapIndex(newHalfEdgeIndices, face.anyHalfEdge);
+    for (auto &halfEdge: m_halfEdges) {
+        halfEdge.startVertex = remapIndex(newVertexIndices, halfEdge.startVertex);
+        halfEdge.leftFace = remapIndex(newFaceIndices, halfEdge.leftFace);
+        halfEdge.previousHalfEdge = remapIndex(newHalfEdgeIndices, halfEdge.previousHalfEdge);
+        halfEdge.nextHalfEdge = remapIndex(newHalfEdgeIndices, halfEdge.nextHalfEdge);
+        halfEdge.oppositeHalfEdge = remapIndex(newHalfEdgeIndices, halfEdge.oppositeHalfEdge);
     }
+    
+    m_removedVertexCount = 0;
+    m_removedFaceCount = 0;
+    m_removedHalfEdgeCount = 0;
+    
+    calculateVertexAdjacency();
 }
 
-void Mesh::deferedFreeVertex(Vertex *vertex)
-{
-    if (vertex == m_firstVertex)
-        m_firstVertex = vertex->_next;
-    if (vertex == m_lastVertex)
-        m_lastVertex = vertex->_previous;
-    if (nullptr != vertex->_next)
-        vertex->_next->_previous = vertex->_previous;
-    if (nullptr != vertex->_previous)
-        vertex->_previous->_next = vertex->_next;
-    --m_vertexCount;
-    vertex->_next = m_firstDeferedRemovalVertex;
-    m_firstDeferedRemovalVertex = vertex;
-}
-
-void Mesh::freeVertex(Vertex *vertex)
-{
-    if (vertex == m_firstVertex)
-        m_firstVertex = vertex->_next;
-    if (vertex == m_lastVertex)
-        m_lastVertex = vertex->_previous;
-    if (nullptr != vertex->_next)
-        vertex->_next->_previous = vertex->_previous;
-    if (nullptr != vertex->_previous)
-        vertex->_previous->_next = vertex->_next;
-    --m_vertexCount;
-    delete vertex;
-}
-
-void Mesh::freeFace(Face *face)
-{
-    if (face == m_firstFace)
-        m_firstFace = face->_next;
-    if (face == m_lastFace)
-        m_lastFace = face->_previous;
-    if (nullptr != face->_next)
-        face->_next->_previous = face->_previous;
-    if (nullptr != face->_previous)
-        face->_previous->_next = face->_next;
-    --m_faceCount;
-    delete face;
+size_t Mesh::vertexCount() const
+{
+    return m_vertices.size() - m_removedVertexCount;
 }
 
-void Mesh::deferedFreeFace(Face *face)
+size_t Mesh::faceCount() const
 {
-    if (face == m_firstFace)
-        m_firstFace = face->_next;
-    if (face == m_lastFace)
-        m_lastFace = face->_previous;
-    if (nullptr != face->_next)
-        face->_next->_previous = face->_previous;
-    if (nullptr != face->_previous)
-        face->_previous->_next = face->_next;
-    --m_faceCount;
-    face->_next = m_firstDeferedRemovalFace;
-    m_firstDeferedRemovalFace = face;
+    return m_faces.size() - m_removedFaceCount;
 }
 
-void Mesh::deferedFreeHalfEdge(HalfEdge *halfEdge)
+std::vector<Vertex> &Mesh::vertices()
 {
-    halfEdge->leftFace = nullptr;
-    if (halfEdge == m_firstHalfEdge)
-        m_firstHalfEdge = halfEdge->_next;
-    if (halfEdge == m_lastHalfEdge)
-        m_lastHalfEdge = halfEdge->_previous;
-    if (nullptr != halfEdge->_next)
-        halfEdge->_next->_previous = halfEdge->_previous;
-    if (nullptr != halfEdge->_previous)
-        halfEdge->_previous->_next = halfEdge->_next;
-    halfEdge->_next = m_firstDeferedRemovalHalfEdge;
-    m_firstDeferedRemovalHalfEdge = halfEdge;
+    return m_vertices;
 }
 
-void Mesh::freeHalfEdge(HalfEdge *halfEdge)
+const std::vector<Vertex> &Mesh::vertices() const
 {
-    if (halfEdge == m_firstHalfEdge)
-        m_firstHalfEdge = halfEdge->_next;
-    if (halfEdge == m_lastHalfEdge)
-        m_lastHalfEdge = halfEdge->_previous;
-    if (nullptr != halfEdge->_next)
-        halfEdge->_next->_previous = halfEdge->_previous;
-    if (nullptr != halfEdge->_previous)
-        halfEdge->_previous->_next = halfEdge->_next;
-    delete halfEdge;
+    return m_vertices;
 }
 
-Vertex *Mesh::allocVertex()
+std::vector<Face> &Mesh::faces()
 {
-    Vertex *vertex = new Vertex;
-    vertex->_previous = m_lastVertex;
-    if (nullptr != m_lastVertex)
-        m_lastVertex->_next = vertex;
-    else
-        m_firstVertex = vertex;
-    m_lastVertex = vertex;
-    ++m_vertexCount;
-    return vertex;
+    return m_faces;
 }
 
-Face *Mesh::allocFace()
+const std::vector<Face> &Mesh::faces() const
 {
-    Face *face = new Face;
-    face->_previous = m_lastFace;
-    if (nullptr != m_lastFace)
-        m_lastFace->_next = face;
-    else
-        m_firstFace = face;
-    m_lastFace = face;
-    ++m_faceCount;
-    return face;
+    return m_faces;
 }
 
-HalfEdge *Mesh::allocHalfEdge()
+std::vector<HalfEdge> &Mesh::halfEdges()
 {
-    HalfEdge *halfEdge = new HalfEdge;
-    halfEdge->_previous = m_lastHalfEdge;
-    if (nullptr != m_lastHalfEdge)
-        m_lastHalfEdge->_next = halfEdge;
-    else
-        m_firstHalfEdge = halfEdge;
-    m_lastHalfEdge = halfEdge;
-    halfEdge->index = m_halfEdgeCount;
-    ++m_halfEdgeCount;
-    return halfEdge;
+    return m_halfEdges;
 }
 
-const size_t &Mesh::vertexCount() const
+const std::vector<HalfEdge> &Mesh::halfEdges() const
 {
-    return m_vertexCount;
+    return m_halfEdges;
 }
 
-const size_t &Mesh::faceCount() const
+const std::vector<Index> &Mesh::vertexNeighborOffsets() const
 {
-    return m_faceCount;
+    return m_vertexNeighborOffsets;
 }
 
-Vertex *Mesh::firstVertex() const
+const std::vector<Index> &Mesh::vertexNeighbors() const
 {
-    return m_firstVertex;
+    return m_vertexNeighbors;
 }
 
-Face *Mesh::firstFace() const
+void Mesh::calculateVertexAdjacency()
 {
-    return m_firstFace;
+    Tracer::ScopedEvent event("HalfEdge::calculateVertexAdjacency");
+    
+    // Each half edge adds its two ends to each other's row, so edges without an opposite are
+    // counted in both directions too; the duplicates are dropped once the rows are sorted
+    std::vector<Index> offsets(m_vertices.size() + 1, 0);
+    for (const auto &halfEdge: m_halfEdges) {
+        if (halfEdge.removed)
+            continue;
+        ++offsets[halfEdge.startVertex + 1];
+        ++offsets[m_halfEdges[halfEdge.nextHalfEdge].startVertex + 1];
+    }
+    for (size_t i = 1; i < offsets.size(); ++i)
+        offsets[i] += offsets[i - 1];
+    std::vector<Index> neighbors(offsets.back());
+    std::vector<Index> rowSizes(offsets.begin(), offsets.end() - 1);
+    for (const auto &halfEdge: m_halfEdges) {
+        if (halfEdge.removed)
+            continue;
+        Index startVertex = halfEdge.startVertex;
+        Index endVertex = m_halfEdges[halfEdge.nextHalfEdge].startVertex;
+        neighbors[rowSizes[startVertex]++] = endVertex;
+        neighbors[rowSizes[endVertex]++] = startVertex;
+    }
+    
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, m_vertices.size()), 
+            [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t vertexIndex = range.begin(); vertexIndex != range.end(); ++vertexIndex) {
+            auto begin = neighbors.begin() + offsets[vertexIndex];
+            auto end = neighbors.begin() + offsets[vertexIndex + 1];
+            std::sort(begin, end);
+            rowSizes[vertexIndex] = (Index)(std::unique(begin, end) - begin);
+        }
+    });
+    
+    m_vertexNeighborOffsets.resize(m_vertices.size() + 1);
+    m_vertexNeighborOffsets[0] = 0;
+    for (size_t i = 0; i < m_vertices.size(); ++i)
+        m_vertexNeighborOffsets[i + 1] = m_vertexNeighborOffsets[i] + rowSizes[i];
+    m_vertexNeighbors.resize(m_vertexNeighborOffsets.back());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, m_vertices.size()), 
+            [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t vertexIndex = range.begin(); vertexIndex != range.end(); ++vertexIndex) {
+            std::copy(neighbors.begin() + offsets[vertexIndex], 
+                neighbors.begin() + offsets[vertexIndex] + rowSizes[vertexIndex],
+                m_vertexNeighbors.begin() + m_vertexNeighborOffsets[vertexIndex]);
+        }
+    });
 }
 
 bool Mesh::isWatertight()
 {
-    return m_faceCount >= 4 && 
+    return faceCount() >= 4 && 
         0 == m_repeatedHalfEdges && 
         0 == m_aloneHalfEdges;
 }
 
-bool Mesh::flip(HalfEdge *halfEdge)
+bool Mesh::flip(Index halfEdge)
 {
     // cf. <Interactively Controlled Quad Remeshing of High Resolution 3D Models> Figure 6
     
-    auto &hflip = halfEdge;
-    auto hflip_x = hflip->oppositeHalfEdge;
-    auto ha = hflip->previousHalfEdge;
-    auto hb = hflip_x->previousHalfEdge;
-    auto hc = hflip->nextHalfEdge;
-    auto hd = hflip_x->nextHalfEdge;
+    Index hflip = halfEdge;
+    Index hflip_x = m_halfEdges[hflip].oppositeHalfEdge;
+    Index ha = m_halfEdges[hflip].previousHalfEdge;
+    Index hb = m_halfEdges[hflip_x].previousHalfEdge;
+    Index hc = m_halfEdges[hflip].nextHalfEdge;
+    Index hd = m_halfEdges[hflip_x].nextHalfEdge;
     
-    auto faceA = hflip->leftFace;
-    auto faceB = hflip_x->leftFace;
+    Index faceA = m_halfEdges[hflip].leftFace;
+    Index faceB = m_halfEdges[hflip_x].leftFace;
     
-    faceA->anyHalfEdge = hflip_x;
-    faceB->anyHalfEdge = hflip;
+    m_faces[faceA].anyHalfEdge = hflip_x;
+    m_faces[faceB].anyHalfEdge = hflip;
     
-    ha->leftFace = faceB;
-    hb->leftFace = faceA;
+    m_halfEdges[ha].leftFace = faceB;
+    m_halfEdges[hb].leftFace = faceA;
     
-    --hflip->startVertex->halfEdgeCount;
-    if (hflip->startVertex->anyHalfEdge == hflip)
-        hflip->startVertex->anyHalfEdge = hd;
+    Vertex &flipStartVertex = m_vertices[m_halfEdges[hflip].startVertex];
+    --flipStartVertex.halfEdgeCount;
+    if (flipStartVertex.anyHalfEdge == hflip)
+        flipStartVertex.anyHalfEdge = hd;
     
-    --hflip_x->startVertex->halfEdgeCount;
-    if (hflip_x->startVertex->anyHalfEdge == hflip_x)
-        hflip_x->startVertex->anyHalfEdge = hc;
+    Vertex &oppositeStartVertex = m_vertices[m_halfEdges[hflip_x].startVertex];
+    --oppositeStartVertex.halfEdgeCount;
+    if (oppositeStartVertex.anyHalfEdge == hflip_x)
+        oppositeStartVertex.anyHalfEdge = hc;
     
-    ++hb->startVertex->halfEdgeCount;
-    ++ha->startVertex->halfEdgeCount;
+    ++m_vertices[m_halfEdges[hb].startVertex].halfEdgeCount;
+    ++m_vertices[m_halfEdges[ha].startVertex].halfEdgeCount;
     
-    hflip->startVertex = hb->startVertex;
-    hflip_x->startVertex = ha->startVertex;
+    m_halfEdges[hflip].startVertex = m_halfEdges[hb].startVertex;
+    m_halfEdges[hflip_x].startVertex = m_halfEdges[ha].startVertex;
     
-    std::swap(hflip->leftFace, hflip_x->leftFace);
+    std::swap(m_halfEdges[hflip].leftFace, m_halfEdges[hflip_x].leftFace);
     
-    makeLinkedHalfEdges(hc, hflip_x);
-    makeLinkedHalfEdges(hflip_x, hb);
-    makeLinkedHalfEdges(hb, hc);
+    makeLinkedHalfEdges(m_halfEdges, hc, hflip_x);
+    makeLinkedHalfEdges(m_halfEdges, hflip_x, hb);
+    makeLinkedHalfEdges(m_halfEdges, hb, hc);
     
-    makeLinkedHalfEdges(hflip, ha);
-    makeLinkedHalfEdges(ha, hd);
-    makeLinkedHalfEdges(hd, hflip);
+    makeLinkedHalfEdges(m_halfEdges, hflip, ha);
+    makeLinkedHalfEdges(m_halfEdges, ha, hd);
+    makeLinkedHalfEdges(m_halfEdges, hd, hflip);
     
     return true;
 }
 
+// The passes below only write the element they visit and read what the previous pass wrote,
+// so they run over the elements in parallel
+
 void Mesh::calculateFaceNormals()
 {
-    for (Face *face = m_firstFace; nullptr != face; face = face->_next) {
-        HalfEdge *h0 = face->anyHalfEdge;
-        HalfEdge *h1 = h0->nextHalfEdge;
-        HalfEdge *h2 = h1->nextHalfEdge;
-        face->normal = Vector3::normal(h0->startVertex->position,
-            h1->startVertex->position,
-            h2->startVertex->position);
-    }
+    Tracer::ScopedEvent event("HalfEdge::calculateFaceNormals");
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, m_faces.size()), 
+            [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t faceIndex = range.begin(); faceIndex != range.end(); ++faceIndex) {
+            Face &face = m_faces[faceIndex];
+            if (face.removed)
+                continue;
+            const HalfEdge &h0 = m_halfEdges[face.anyHalfEdge];
+            const HalfEdge &h1 = m_halfEdges[h0.nextHalfEdge];
+            const HalfEdge &h2 = m_halfEdges[h1.nextHalfEdge];
+            face.normal = Vector3::normal(m_vertices[h0.startVertex].position,
+                m_vertices[h1.startVertex].position,
+                m_vertices[h2.startVertex].position);
+        }
+    });
 }
 
 void Mesh::calculateVertexNormals()
 {
-    for (Vertex *vertex = m_firstVertex; nullptr != vertex; vertex = vertex->_next) {
-        HalfEdge *halfEdge = vertex->anyHalfEdge;
-        do {
-            vertex->normal += halfEdge->leftFace->normal;
-            if (nullptr == halfEdge->oppositeHalfEdge)
-                break;
-            halfEdge = halfEdge->oppositeHalfEdge->nextHalfEdge;
-        } while (halfEdge && halfEdge != vertex->anyHalfEdge);
-        vertex->normal.normalize();
-    }
+    Tracer::ScopedEvent event("HalfEdge::calculateVertexNormals");
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, m_vertices.size()), 
+            [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t vertexIndex = range.begin(); vertexIndex != range.end(); ++vertexIndex) {
+            Vertex &vertex = m_vertices[vertexIndex];
+            if (vertex.removed || InvalidIndex == vertex.anyHalfEdge)
+                continue;
+            Index halfEdge = vertex.anyHalfEdge;
+            do {
+                vertex.normal += m_faces[m_halfEdges[halfEdge].leftFace].normal;
+                Index opposite = m_halfEdges[halfEdge].oppositeHalfEdge;
+                if (InvalidIndex == opposite)
+                    break;
+                halfEdge = m_halfEdges[opposite].nextHalfEdge;
+            } while (halfEdge != vertex.anyHalfEdge);
+            vertex.normal.normalize();
+        }
+    });
 }
 
 void Mesh::calculateVertexAverageNormals()
 {
-    for (Vertex *vertex = m_firstVertex; nullptr != vertex; vertex = vertex->_next) {
-        HalfEdge *halfEdge = vertex->anyHalfEdge;
-        do {
-            if (nullptr == halfEdge->oppositeHalfEdge)
-                break;
-            vertex->averageNormal += halfEdge->oppositeHalfEdge->startVertex->normal;
-            halfEdge = halfEdge->oppositeHalfEdge->nextHalfEdge;
-        } while (halfEdge && halfEdge != vertex->anyHalfEdge);
-        vertex->averageNormal.normalize();
-        if (vertex->averageNormal.isZero())
-            vertex->averageNormal = vertex->normal;
-    }
+    Tracer::ScopedEvent event("HalfEdge::calculateVertexAverageNormals");
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, m_vertices.size()), 
+            [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t vertexIndex = range.begin(); vertexIndex != range.end(); ++vertexIndex) {
+            Vertex &vertex = m_vertices[vertexIndex];
+            if (vertex.removed || InvalidIndex == vertex.anyHalfEdge)
+                continue;
+            Index halfEdge = vertex.anyHalfEdge;
+            do {
+                Index opposite = m_halfEdges[halfEdge].oppositeHalfEdge;
+                if (InvalidIndex == opposite)
+                    break;
+                vertex.averageNormal += m_vertices[m_halfEdges[opposite].startVertex].normal;
+                halfEdge = m_halfEdges[opposite].nextHalfEdge;
+            } while (halfEdge != vertex.anyHalfEdge);
+            vertex.averageNormal.normalize();
+            if (vertex.averageNormal.isZero())
+                vertex.averageNormal = vertex.normal;
+        }
+    });
 }
 
 void Mesh::calculateVertexRelativeHeights()
 {
-    for (Vertex *vertex = m_firstVertex; nullptr != vertex; vertex = vertex->_next) {
-        HalfEdge *halfEdge = vertex->anyHalfEdge;
-        double low = 0.0;
-        double high = 0.0;
-        bool isBoundary = false;
-        auto project = [&](const Vector3 &position) {
-            double projectedTo = Vector3::dotProduct((position - vertex->position).normalized(), vertex->averageNormal);
-            if (projectedTo < low)
-                low = projectedTo;
-            if (projectedTo > high)
-                high = projectedTo;
-        };
-        do {
-            if (nullptr == halfEdge->oppositeHalfEdge) {
-                isBoundary = true;
-                break;
-            }
-            Vertex *neighborVertex = halfEdge->oppositeHalfEdge->startVertex;
-            project(neighborVertex->position);
-            HalfEdge *neighborHalfEdge = neighborVertex->anyHalfEdge;
-            do {
-                if (nullptr == neighborHalfEdge->oppositeHalfEdge) {
-                    isBoundary = true;
-                    break;
-                }
-                if (neighborHalfEdge->oppositeHalfEdge->startVertex != vertex)
-                    project(neighborHalfEdge->oppositeHalfEdge->startVertex->position);
-                neighborHalfEdge = neighborHalfEdge->oppositeHalfEdge->nextHalfEdge;
-            } while (neighborHalfEdge && neighborHalfEdge != neighborVertex->anyHalfEdge);
-            halfEdge = halfEdge->oppositeHalfEdge->nextHalfEdge;
-        } while (halfEdge && halfEdge != vertex->anyHalfEdge);
-        if (!isBoundary) {
-            vertex->relativeHeight = high - low;
-            vertex->hasRelativeHeight = true;
-        } else {
-            vertex->relativeHeight = std::numeric_limits<double>::max();
+    Tracer::ScopedEvent event("HalfEdge::calculateVertexRelativeHeights");
+    
+    // The ends of an edge without an opposite are on the boundary
+    std::vector<uint8_t> boundaryVertices(m_vertices.size(), 0);
+    for (const auto &halfEdge: m_halfEdges) {
+        if (halfEdge.removed || InvalidIndex != halfEdge.oppositeHalfEdge)
+            continue;
+        boundaryVertices[halfEdge.startVertex] = 1;
+        boundaryVertices[m_halfEdges[halfEdge.nextHalfEdge].startVertex] = 1;
+    }
+    
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, m_vertices.size()), 
+            [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t vertexIndex = range.begin(); vertexIndex != range.end(); ++vertexIndex)
+            calculateVertexRelativeHeight((Index)vertexIndex, boundaryVertices);
+    });
+}
+
+void Mesh::calculateVertexRelativeHeight(Index vertexIndex, const std::vector<uint8_t> &boundaryVertices)
+{
+    Vertex &vertex = m_vertices[vertexIndex];
+    if (vertex.removed || InvalidIndex == vertex.anyHalfEdge)
+        return;
+    
+    // The two ring is gathered from the adjacency rows, vertices shared by several
+    // neighbors are projected more than once, which leaves the low and high unchanged
+    Index neighborsBegin = m_vertexNeighborOffsets[vertexIndex];
+    Index neighborsEnd = m_vertexNeighborOffsets[vertexIndex + 1];
+    bool isBoundary = boundaryVertices[vertexIndex];
+    for (Index i = neighborsBegin; i < neighborsEnd && !isBoundary; ++i)
+        isBoundary = boundaryVertices[m_vertexNeighbors[i]];
+    if (isBoundary) {
+        vertex.relativeHeight = std::numeric_limits<double>::max();
+        return;
+    }
+    
+    double low = 0.0;
+    double high = 0.0;
+    auto project = [&](const Vector3 &position) {
+        double projectedTo = Vector3::dotProduct((position - vertex.position).normalized(), vertex.averageNormal);
+        if (projectedTo < low)
+            low = projectedTo;
+        if (projectedTo > high)
+            high = projectedTo;
+    };
+    for (Index i = neighborsBegin; i < neighborsEnd; ++i) {
+        Index neighbor = m_vertexNeighbors[i];
+        project(m_vertices[neighbor].position);
+        for (Index j = m_vertexNeighborOffsets[neighbor]; j < m_vertexNeighborOffsets[neighbor + 1]; ++j) {
+            Index farVertex = m_vertexNeighbors[j];
+            if (farVertex != vertexIndex)
+                project(m_vertices[farVertex].position);
         }
     }
+    vertex.relativeHeight = high - low;
+    vertex.hasRelativeHeight = true;
 }
 
 void Mesh::normalizeVertexRelativeHeights()
 {
     double maxHeight = 0;
-    for (Vertex *vertex = m_firstVertex; nullptr != vertex; vertex = vertex->_next) {
-        if (vertex->hasRelativeHeight && vertex->relativeHeight > maxHeight)
-            maxHeight = vertex->relativeHeight;
+    for (const auto &vertex: m_vertices) {
+        if (!vertex.removed && vertex.hasRelativeHeight && vertex.relativeHeight > maxHeight)
+            maxHeight = vertex.relativeHeight;
     }
     if (Double::isZero(maxHeight))
         return;
-    for (Vertex *vertex = m_firstVertex; nullptr != vertex; vertex = vertex->_next) {
-        if (vertex->hasRelativeHeight)
-            vertex->relativeHeight /= maxHeight;
+    for (auto &vertex: m_vertices) {
+        if (!vertex.removed && vertex.hasRelativeHeight)
+            vertex.relativeHeight /= maxHeight;
     }
 }
 
 void Mesh::removeZeroAngleTriangles()
 {
-    std::vector<HalfEdge *> candidates;
-    for (HalfEdge *halfEdge = m_firstHalfEdge; nullptr != halfEdge; halfEdge = halfEdge->_next) {
-        auto v1 = halfEdge->nextHalfEdge->startVertex->position - halfEdge->startVertex->position;
-        auto v2 = halfEdge->previousHalfEdge->startVertex->position - halfEdge->startVertex->position;
-        auto degrees = Radians::toDegrees(Vector3::angle(v1, v2));
-        if (degrees <= 179.9)
+    auto cornerDegrees = [&](const HalfEdge &halfEdge) {
+        const Vector3 &position = m_vertices[halfEdge.startVertex].position;
+        auto v1 = m_vertices[m_halfEdges[halfEdge.nextHalfEdge].startVertex].position - position;
+        auto v2 = m_vertices[m_halfEdges[halfEdge.previousHalfEdge].startVertex].position - position;
+        return Radians::toDegrees(Vector3::angle(v1, v2));
+    };
+    
+    std::vector<Index> candidates;
+    for (Index halfEdgeIndex = 0; halfEdgeIndex < m_halfEdges.size(); ++halfEdgeIndex) {
+        const HalfEdge &halfEdge = m_halfEdges[halfEdgeIndex];
+        if (halfEdge.removed || cornerDegrees(halfEdge) <= 179.9)
             continue;
-        candidates.push_back(halfEdge);
+        candidates.push_back(halfEdgeIndex);
     }
     
-    for (auto &halfEdge: candidates) {
-        if (nullptr == halfEdge->leftFace)
+    for (const auto &halfEdgeIndex: candidates) {
+        const HalfEdge &halfEdge = m_halfEdges[halfEdgeIndex];
+        if (InvalidIndex == halfEdge.leftFace)
             continue;
         
-        auto v1 = halfEdge->nextHalfEdge->startVertex->position - halfEdge->startVertex->position;
-        auto v2 = halfEdge->previousHalfEdge->startVertex->position - halfEdge->startVertex->position;
-        auto degrees = Radians::toDegrees(Vector3::angle(v1, v2));
-        if (degrees <= 179.9)
+        if (cornerDegrees(halfEdge) <= 179.9)
             continue;
         
-        flip(halfEdge->nextHalfEdge);
+        flip(halfEdge.nextHalfEdge);
     }
 }
 
-void Mesh::orderVertexByFlatness()
-{
-    m_vertexOrderedByFlatness.resize(m_vertexCount);
-    size_t vertexIndex = 0;
-    for (Vertex *vertex = m_firstVertex; nullptr != vertex; vertex = vertex->_next) {
-        m_vertexOrderedByFlatness[vertexIndex] = vertex;
-        ++vertexIndex;
-    }
-    std::sort(m_vertexOrderedByFlatness.begin(), m_vertexOrderedByFlatness.end(), 
-            [](const Vertex *first, const Vertex *second) {
-        return first->relativeHeight < second->relativeHeight;
-    });
-}
-
-const std::vector<Vertex *> &Mesh::vertexOrderedByFlatness()
-{
-    return m_vertexOrderedByFlatness;
-}
-
 #if AUTO_REMESHER_DEV
 
 void Mesh::debugExportRelativeHeightPly(const char *filename)
 {
-    for (Vertex *vertex = m_firstVertex; nullptr != vertex; vertex = vertex->_next) {
-        vertex->debugColor = (1.0 - vertex->relativeHeight) * 255;
+    for (auto &vertex: m_vertices) {
+        vertex.debugColor = (1.0 - vertex.relativeHeight) * 255;
     }
     debugExportPly(filename);
 }
 
 void Mesh::debugExportLimitRelativeHeightPly(const char *filename, float limitRelativeHeight)
 {
-    for (Vertex *vertex = m_firstVertex; nullptr != vertex; vertex = vertex->_next) {
-        vertex->debugColor = vertex->relativeHeight > limitRelativeHeight ? 0 : 127 + (1.0 - limitRelativeHeight * vertex->relativeHeight) * 100;
+    for (auto &vertex: m_vertices) {
+        vertex.debugColor = vertex.relativeHeight > limitRelativeHeight ? 0 : 127 + (1.0 - limitRelativeHeight * vertex.relativeHeight) * 100;
     }
     debugExportPly(filename);
 }
@@ -518,35 +629,35 @@ void Mesh::debugExportPly(const char *filename)
 {
     std::cerr << "debugExportPly:" << filename << std::endl;
     
+    compact();
+    
     FILE *fp = fopen(filename, "wb");
     fprintf(fp, "ply\n");
     fprintf(fp, "format ascii 1.0\n");
-    fprintf(fp, "element vertex %zu\n", m_vertexCount);
+    fprintf(fp, "element vertex %zu\n", m_vertices.size());
     fprintf(fp, "property float x\n");
     fprintf(fp, "property float y\n");
     fprintf(fp, "property float z\n");
     fprintf(fp, "property uchar red\n");
     fprintf(fp, "property uchar green\n");
     fprintf(fp, "property uchar blue\n");
-    fprintf(fp, "element face %zu\n", m_faceCount);
+    fprintf(fp, "element face %zu\n", m_faces.size());
     fprintf(fp, "property list uchar uint vertex_indices\n");
     fprintf(fp, "end_header\n");
-    size_t index = 0;
-    for (Vertex *vertex = m_firstVertex; nullptr != vertex; vertex = vertex->_next) {
-        vertex->outputIndex = index++;
-        int c = vertex->debugColor > 255 ? 255 : vertex->debugColor;
+    for (const auto &vertex: m_vertices) {
+        int c = vertex.debugColor > 255 ? 255 : vertex.debugColor;
         fprintf(fp, "%f %f %f %d %d %d\n", 
-            vertex->position.x(), vertex->position.y(), vertex->position.z(),
+            vertex.position.x(), vertex.position.y(), vertex.position.z(),
             c, c, c);
     }
-    for (Face *face = m_firstFace; nullptr != face; face = face->_next) {
-        HalfEdge *h0 = face->anyHalfEdge;
-        HalfEdge *h1 = h0->nextHalfEdge;
-        HalfEdge *h2 = h1->nextHalfEdge;
-        fprintf(fp, "3 %zu %zu %zu\n",
-            h0->startVertex->outputIndex, 
-            h1->startVertex->outputIndex, 
-            h2->startVertex->outputIndex);
+    for (const auto &face: m_faces) {
+        const HalfEdge &h0 = m_halfEdges[face.anyHalfEdge];
+        const HalfEdge &h1 = m_halfEdges[h0.nextHalfEdge];
+        const HalfEdge &h2 = m_halfEdges[h1.nextHalfEdge];
+        fprintf(fp, "3 %u %u %u\n",
+            h0.startVertex, 
+            h1.startVertex, 
+            h2.startVertex);
     }
     fclose(fp);
 }
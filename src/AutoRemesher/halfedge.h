@@ -23,34 +23,33 @@
 #define AUTO_REMESHER_HALF_EDGE_H
 #include <vector>
 #include <cstddef>
+#include <cstdint>
 #include <queue>
 #include <limits>
 #include <AutoRemesher/Vector3>
 #include <AutoRemesher/Vector2>
+#include <AutoRemesher/ArrayView>
 
 namespace AutoRemesher
 {
     
 namespace HalfEdge
 {
-    
-struct Vertex;
-struct HalfEdge;
-struct Face;
+
+// Elements live in three contiguous arrays and refer to each other by their position in them
+typedef uint32_t Index;
+const Index InvalidIndex = std::numeric_limits<Index>::max();
 
 struct Vertex
 {
-    Vertex *_previous = nullptr;
-    Vertex *_next = nullptr;
-    size_t index;
-    size_t outputIndex;
     Vector3 position;
-    HalfEdge *anyHalfEdge = nullptr;
-    size_t halfEdgeCount = 0;
+    Index anyHalfEdge = InvalidIndex;
+    uint32_t halfEdgeCount = 0;
     Vector3 normal;
     Vector3 averageNormal;
-    bool hasRelativeHeight = false;
     double relativeHeight = 0.0;
+    bool hasRelativeHeight = false;
+    bool removed = false;
 #if AUTO_REMESHER_DEV
     unsigned char debugColor = 0;
 #endif
@@ -58,54 +57,58 @@ struct Vertex
 
 struct HalfEdge
 {
-    HalfEdge *_previous = nullptr;
-    HalfEdge *_next = nullptr;
-    size_t index;
-    Vertex *startVertex = nullptr;
-    Face *leftFace = nullptr;
-    HalfEdge *previousHalfEdge = nullptr;
-    HalfEdge *nextHalfEdge = nullptr;
-    HalfEdge *oppositeHalfEdge = nullptr;
+    Index startVertex = InvalidIndex;
+    Index leftFace = InvalidIndex;
+    Index previousHalfEdge = InvalidIndex;
+    Index nextHalfEdge = InvalidIndex;
+    Index oppositeHalfEdge = InvalidIndex;
+    bool removed = false;
     Vector2 startVertexUv;
 };
 
 struct Face
 {
-    Face *_previous = nullptr;
-    Face *_next = nullptr;
-    HalfEdge *anyHalfEdge = nullptr;
+    Index anyHalfEdge = InvalidIndex;
+    bool removed = false;
     Vector3 normal;
 };
 
 class Mesh
 {
 public:
-    Mesh(const std::vector<Vector3> &vertices,
-        const std::vector<std::vector<size_t>> &triangles);
-    ~Mesh();
-    Vertex *allocVertex();
-    Face *allocFace();
-    HalfEdge *allocHalfEdge();
-    void freeVertex(Vertex *vertex);
-    void deferedFreeVertex(Vertex *vertex);
-    void freeFace(Face *face);
-    void freeHalfEdge(HalfEdge *halfEdge);
-    void deferedFreeHalfEdge(HalfEdge *halfEdge);
-    void deferedFreeFace(Face *face);
-    bool flip(HalfEdge *halfEdge);
+    Mesh(ArrayView<Vector3> vertices,
+        ArrayView<uint32_t> triangleIndices);
+    Index addVertex();
+    Index addFace();
+    Index addHalfEdge();
+    // Removed elements are only marked, indices held elsewhere stay valid until compact()
+    void removeVertex(Index vertex);
+    void removeFace(Index face);
+    void removeHalfEdge(Index halfEdge);
+    // Drops the removed elements and renumbers every reference, afterwards the indices run from 0 to the count
+    void compact();
+    bool flip(Index halfEdge);
     bool isWatertight();
-    const size_t &vertexCount() const;
-    const size_t &faceCount() const;
-    Vertex *firstVertex() const;
-    Face *firstFace() const;
+    size_t vertexCount() const;
+    size_t faceCount() const;
+    std::vector<Vertex> &vertices();
+    const std::vector<Vertex> &vertices() const;
+    std::vector<Face> &faces();
+    const std::vector<Face> &faces() const;
+    std::vector<HalfEdge> &halfEdges();
+    const std::vector<HalfEdge> &halfEdges() const;
+    // Vertex adjacency in compressed rows, the neighbors of vertex i are vertexNeighbors() from
+    // vertexNeighborOffsets()[i] up to vertexNeighborOffsets()[i + 1], in ascending order;
+    // built with the mesh and again by compact(), so flips made in between are not reflected
+    const std::vector<Index> &vertexNeighborOffsets() const;
+    const std::vector<Index> &vertexNeighbors() const;
+    void calculateVertexAdjacency();
     void calculateFaceNormals();
     void calculateVertexNormals();
     void calculateVertexAverageNormals();
     void calculateVertexRelativeHeights();
     void normalizeVertexRelativeHeights();
     void removeZeroAngleTriangles();
-    void orderVertexByFlatness();
-    const std::vector<Vertex *> &vertexOrderedByFlatness();
 #if AUTO_REMESHER_DEV
     void debugExportRelativeHeightPly(const char *filename);
     void debugExportLimitRelativeHeightPly(const char *filename, float limitRelativeHeight);
@@ -113,22 +116,19 @@ public:
 #endif
     
 private:
-
-    Vertex *m_firstVertex = nullptr;
-    Vertex *m_lastVertex = nullptr;
-    Vertex *m_firstDeferedRemovalVertex = nullptr;
-    Face *m_firstFace = nullptr;
-    Face *m_lastFace = nullptr;
-    HalfEdge *m_firstHalfEdge = nullptr;
-    HalfEdge *m_lastHalfEdge = nullptr;
-    HalfEdge *m_firstDeferedRemovalHalfEdge = nullptr;
-    Face *m_firstDeferedRemovalFace = nullptr;
+    std::vector<Vertex> m_vertices;
+    std::vector<Face> m_faces;
+    std::vector<HalfEdge> m_halfEdges;
+    std::vector<Index> m_vertexNeighborOffsets;
+    std::vector<Index> m_vertexNeighbors;
+    size_t m_removedVertexCount = 0;
+    size_t m_removedFaceCount = 0;
+    size_t m_removedHalfEdgeCount = 0;
     size_t m_repeatedHalfEdges = 0;
     size_t m_aloneHalfEdges = 0;
-    size_t m_vertexCount = 0;
-    size_t m_faceCount = 0;
-    size_t m_halfEdgeCount = 0;
-    std::vector<Vertex *> m_vertexOrderedByFlatness;
+    
+    void linkOppositeHalfEdges(ArrayView<uint32_t> triangleIndices);
+    void calculateVertexRelativeHeight(Index vertexIndex, const std::vector<uint8_t> &boundaryVertices);
 };
 
 }
@@ -0,0 +1,184 @@
+/*
+ *  Copyright (c) 2020 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#include <cstdio>
+#include <cstring>
+#include <cinttypes>
+#include <thread>
+#include <functional>
+#include <exception>
+#include <AutoRemesher/IslandCache>
+
+namespace AutoRemesher
+{
+    
+const uint64_t IslandCache::m_hashOffsetBasis = 14695981039346656037ULL;
+const uint32_t IslandCache::m_fileVersion = 4;
+
+static const char s_fileMagic[4] = {'A', 'R', 'Q', 'C'};
+
+uint64_t IslandCache::hash(const void *data, size_t size, uint64_t hash)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+std::string IslandCache::filenameForKey(uint64_t key) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016" PRIx64 ".arq", key);
+    return m_directory + "/" + name;
+}
+
+// A damaged or foreign file may claim any counts in its header, they are only trusted when the rest
+// of the file holds exactly that many coordinates and indices
+static bool hasPayloadSize(FILE *fp, uint64_t vertexCount, uint64_t quadCount)
+{
+    long position = ftell(fp);
+    if (position < 0 || 0 != fseek(fp, 0, SEEK_END))
+        return false;
+    long end = ftell(fp);
+    if (end < position || 0 != fseek(fp, position, SEEK_SET))
+        return false;
+    uint64_t payloadSize = (uint64_t)(end - position);
+    const uint64_t bytesPerVertex = 3 * sizeof(double);
+    const uint64_t bytesPerQuad = 4 * sizeof(uint32_t);
+    if (vertexCount > payloadSize / bytesPerVertex || quadCount > payloadSize / bytesPerQuad)
+        return false;
+    return vertexCount * bytesPerVertex + quadCount * bytesPerQuad == payloadSize;
+}
+
+bool IslandCache::load(uint64_t key, 
+    std::vector<Vector3> *vertices, 
+    std::vector<uint32_t> *quadIndices) const
+{
+    FILE *fp = fopen(filenameForKey(key).c_str(), "rb");
+    if (nullptr == fp)
+        return false;
+    
+    bool succeed = false;
+    char magic[4];
+    uint32_t version = 0;
+    uint64_t storedKey = 0;
+    uint64_t vertexCount = 0;
+    uint64_t quadCount = 0;
+    if (1 == fread(magic, sizeof(magic), 1, fp) &&
+            0 == memcmp(magic, s_fileMagic, sizeof(magic)) &&
+            1 == fread(&version, sizeof(version), 1, fp) &&
+            m_fileVersion == version &&
+            1 == fread(&storedKey, sizeof(storedKey), 1, fp) &&
+            key == storedKey &&
+            1 == fread(&vertexCount, sizeof(vertexCount), 1, fp) &&
+            1 == fread(&quadCount, sizeof(quadCount), 1, fp) &&
+            hasPayloadSize(fp, vertexCount, quadCount)) {
+        // The counts match the file size by now, running out of memory is still only a miss
+        std::vector<double> coords;
+        try {
+            coords.resize(vertexCount * 3);
+            quadIndices->resize(quadCount * 4);
+        } catch (const std::exception &) {
+            fclose(fp);
+            quadIndices->clear();
+            return false;
+        }
+        if ((coords.empty() || coords.size() == fread(coords.data(), sizeof(double), coords.size(), fp)) &&
+                (quadIndices->empty() || quadIndices->size() == fread(quadIndices->data(), sizeof(uint32_t), quadIndices->size(), fp))) {
+            succeed = true;
+            for (const auto &index: *quadIndices) {
+                if (index >= vertexCount) {
+                    succeed = false;
+                    break;
+                }
+            }
+        }
+        if (succeed) {
+            vertices->resize(vertexCount);
+            for (size_t i = 0, j = 0; i < vertices->size(); ++i, j += 3)
+                (*vertices)[i] = Vector3(coords[j], coords[j + 1], coords[j + 2]);
+        } else {
+            quadIndices->clear();
+        }
+    }
+    
+    fclose(fp);
+    return succeed;
+}
+
+bool IslandCache::save(uint64_t key, 
+    ArrayView<Vector3> vertices, 
+    ArrayView<uint32_t> quadIndices) const
+{
+    std::vector<double> coords;
+    coords.reserve(vertices.size() * 3);
+    for (const auto &it: vertices) {
+        coords.push_back(it.x());
+        coords.push_back(it.y());
+        coords.push_back(it.z());
+    }
+    // Written next to the final name and renamed, so concurrent runs never see a partial file. The process
+    // id keeps processes sharing the directory apart, thread id hashes of different processes can collide
+#ifdef _WIN32
+    unsigned long processId = GetCurrentProcessId();
+#else
+    unsigned long processId = (unsigned long)getpid();
+#endif
+    std::string filename = filenameForKey(key);
+    std::string temporaryFilename = filename + "." + std::to_string(processId) + "." +
+        std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+    FILE *fp = fopen(temporaryFilename.c_str(), "wb");
+    if (nullptr == fp)
+        return false;
+    uint64_t vertexCount = vertices.size();
+    uint64_t quadCount = quadIndices.size() / 4;
+    bool succeed = 1 == fwrite(s_fileMagic, sizeof(s_fileMagic), 1, fp) &&
+        1 == fwrite(&m_fileVersion, sizeof(m_fileVersion), 1, fp) &&
+        1 == fwrite(&key, sizeof(key), 1, fp) &&
+        1 == fwrite(&vertexCount, sizeof(vertexCount), 1, fp) &&
+        1 == fwrite(&quadCount, sizeof(quadCount), 1, fp) &&
+        (coords.empty() || coords.size() == fwrite(coords.data(), sizeof(double), coords.size(), fp)) &&
+        (quadIndices.empty() || quadIndices.size() == fwrite(quadIndices.data(), sizeof(uint32_t), quadIndices.size(), fp));
+    if (0 != fclose(fp))
+        succeed = false;
+    if (succeed) {
+#ifdef _WIN32
+        // Another process may have stored the same key meanwhile, the content is the same either way
+        remove(filename.c_str());
+#endif
+        succeed = 0 == rename(temporaryFilename.c_str(), filename.c_str());
+    }
+    if (!succeed)
+        remove(temporaryFilename.c_str());
+    return succeed;
+}
+
+}
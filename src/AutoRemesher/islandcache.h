@@ -0,0 +1,64 @@
+/*
+ *  Copyright (c) 2020 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+#ifndef AUTO_REMESHER_ISLAND_CACHE_H
+#define AUTO_REMESHER_ISLAND_CACHE_H
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <AutoRemesher/Vector3>
+#include <AutoRemesher/ArrayView>
+
+namespace AutoRemesher
+{
+    
+// Remeshed quads of single islands stored on disk, one file per key. The key is expected to be a hash
+// of everything the result depends on, so entries are never invalidated, only missed
+class IslandCache
+{
+public:
+    IslandCache(const std::string &directory) :
+        m_directory(directory)
+    {
+    }
+    
+    bool load(uint64_t key, 
+        std::vector<Vector3> *vertices, 
+        std::vector<uint32_t> *quadIndices) const;
+    bool save(uint64_t key, 
+        ArrayView<Vector3> vertices, 
+        ArrayView<uint32_t> quadIndices) const;
+    
+    // 64 bit FNV-1a, chain calls by passing the previous result as the hash
+    static uint64_t hash(const void *data, size_t size, uint64_t hash=m_hashOffsetBasis);
+    
+    static const uint64_t m_hashOffsetBasis;
+    static const uint32_t m_fileVersion;
+private:
+    std::string m_directory;
+    
+    std::string filenameForKey(uint64_t key) const;
+};
+    
+}
+
+#endif
@@ -28,9 +28,12 @@
 #include <CGAL/Polygon_mesh_processing/remesh.h>
 #include <CGAL/Polygon_mesh_processing/border.h>
 #include <CGAL/Polygon_mesh_processing/repair.h>
+#include <CGAL/Polygon_mesh_processing/compute_normal.h>
+#include <CGAL/Polygon_mesh_processing/measure.h>
 #include <boost/function_output_iterator.hpp>
 #include <AutoRemesher/Vector3>
 #include <AutoRemesher/IsotropicRemesher>
+#include <AutoRemesher/Tracer>
 
 typedef CGAL::Exact_predicates_inexact_constructions_kernel     Kernel;
 typedef Kernel::Point_3                                         Point;
@@ -41,21 +44,87 @@ typedef boost::graph_traits<Mesh>::edge_descriptor              edge_descriptor;
 namespace AutoRemesher
 {
 
-bool IsotropicRemesher::remesh()
+struct IsotropicRemesher::PreprocessedMesh::Data
 {
     Mesh mesh;
+    double area = 0.0;
+};
+
+IsotropicRemesher::PreprocessedMesh::PreprocessedMesh(ArrayView<Vector3> vertices,
+        ArrayView<uint32_t> triangleIndices) :
+    m_data(new Data)
+{
+    Tracer::ScopedEvent event("IsotropicRemesher::PreprocessedMesh");
+    Mesh &mesh = m_data->mesh;
     
-    std::vector<Mesh::Vertex_index> vertices;
-    vertices.reserve(m_vertices.size());
-    for (const auto &position: m_vertices)
-        vertices.push_back(mesh.add_vertex(Point(position.x(), position.y(), position.z())));
-    for (const auto &face: m_triangles)
-        mesh.add_face(vertices[face[0]], vertices[face[1]], vertices[face[2]]);
+    std::vector<Mesh::Vertex_index> meshVertices;
+    meshVertices.reserve(vertices.size());
+    for (const auto &position: vertices)
+        meshVertices.push_back(mesh.add_vertex(Point(position.x(), position.y(), position.z())));
+    for (size_t i = 0; i + 2 < triangleIndices.size(); i += 3) {
+        mesh.add_face(meshVertices[triangleIndices[i]], 
+            meshVertices[triangleIndices[i + 1]], 
+            meshVertices[triangleIndices[i + 2]]);
+    }
     
     CGAL::Polygon_mesh_processing::remove_degenerate_faces(mesh);
     
-    auto ecm = mesh.add_property_map<edge_descriptor, bool>("ecm").first;
-    CGAL::Polygon_mesh_processing::detect_sharp_edges(mesh, m_sharpEdgeDegrees, ecm);
+    // Same test as CGAL::Polygon_mesh_processing::detect_sharp_edges, kept as the cosine between the face normals
+    auto dihedralCosines = mesh.add_property_map<edge_descriptor, double>("e:dihedralCosine", 1.0).first;
+    for (edge_descriptor e: edges(mesh)) {
+        halfedge_descriptor h = halfedge(e, mesh);
+        if (CGAL::is_border(e, mesh))
+            continue;
+        const auto &n1 = CGAL::Polygon_mesh_processing::compute_face_normal(face(h, mesh), mesh);
+        const auto &n2 = CGAL::Polygon_mesh_processing::compute_face_normal(face(opposite(h, mesh), mesh), mesh);
+        dihedralCosines[e] = n1 * n2;
+    }
+    
+    m_data->area = CGAL::to_double(CGAL::Polygon_mesh_processing::area(mesh));
+}
+
+IsotropicRemesher::PreprocessedMesh::~PreprocessedMesh()
+{
+    delete m_data;
+}
+
+double IsotropicRemesher::PreprocessedMesh::area() const
+{
+    return m_data->area;
+}
+
+size_t IsotropicRemesher::PreprocessedMesh::vertexCount() const
+{
+    return m_data->mesh.number_of_vertices();
+}
+
+bool IsotropicRemesher::remesh()
+{
+    Tracer::ScopedEvent event("IsotropicRemesher::remesh");
+    PreprocessedMesh *ownPreprocessedMesh = nullptr;
+    if (nullptr == m_preprocessedMesh) {
+        ownPreprocessedMesh = new PreprocessedMesh(m_vertices, m_triangleIndices);
+        m_preprocessedMesh = ownPreprocessedMesh;
+    }
+    
+    Mesh mesh = m_preprocessedMesh->m_data->mesh;
+    
+    auto dihedralCosines = mesh.property_map<edge_descriptor, double>("e:dihedralCosine").first;
+    auto ecm = mesh.add_property_map<edge_descriptor, bool>("ecm", false).first;
+    double sharpEdgeCosine = std::cos(m_sharpEdgeDegrees * CGAL_PI / 180.0);
+    for (edge_descriptor e: edges(mesh)) {
+        if (CGAL::is_border(e, mesh) ||
+                Double::isZero(m_sharpEdgeDegrees) ||
+                (!Double::isEqual(m_sharpEdgeDegrees, 180.0) && dihedralCosines[e] <= sharpEdgeCosine)) {
+            ecm[e] = true;
+        }
+    }
+    mesh.remove_property_map(dihedralCosines);
+    
+    if (nullptr != ownPreprocessedMesh) {
+        delete ownPreprocessedMesh;
+        m_preprocessedMesh = nullptr;
+    }
     
     std::vector<edge_descriptor> border;
     for (edge_descriptor e: edges(mesh)) {
@@ -72,13 +141,14 @@ bool IsotropicRemesher::remesh()
         .protect_constraints(true)
         .edge_is_constrained_map(ecm));
     
-    Mesh::Property_map<Mesh::Vertex_index, size_t> meshPropertyMap;
+    Mesh::Property_map<Mesh::Vertex_index, uint32_t> meshPropertyMap;
     bool created;
-    boost::tie(meshPropertyMap, created) = mesh.add_property_map<Mesh::Vertex_index, size_t>("v:source", 0);
+    boost::tie(meshPropertyMap, created) = mesh.add_property_map<Mesh::Vertex_index, uint32_t>("v:source", 0);
     
+    m_remeshedVertices.reserve(mesh.number_of_vertices());
     for (auto vertexIt = mesh.vertices_begin(); vertexIt != mesh.vertices_end(); vertexIt++) {
         auto point = mesh.point(*vertexIt);
-        meshPropertyMap[*vertexIt] = m_remeshedVertices.size();
+        meshPropertyMap[*vertexIt] = (uint32_t)m_remeshedVertices.size();
         m_remeshedVertices.push_back(Vector3 {
             CGAL::to_double(point.x()),
             CGAL::to_double(point.y()),
@@ -86,15 +156,14 @@ bool IsotropicRemesher::remesh()
         });
     }
     
+    m_remeshedTriangleIndices.reserve(mesh.number_of_faces() * 3);
     for (const auto &faceIt: mesh.faces()) {
         CGAL::Vertex_around_face_iterator<Mesh> vbegin, vend;
-        std::vector<size_t> faceIndices;
         for (boost::tie(vbegin, vend) = CGAL::vertices_around_face(mesh.halfedge(faceIt), mesh);
                 vbegin != vend;
                 ++vbegin) {
-            faceIndices.push_back(meshPropertyMap[*vbegin]);
+            m_remeshedTriangleIndices.push_back(meshPropertyMap[*vbegin]);
         }
-        m_remeshedTriangles.push_back(faceIndices);
     }
         
     return true;
@@ -107,9 +176,11 @@ void IsotropicRemesher::debugExportObj(const char *filename)
         fprintf(fp, "v %f %f %f\n",
             it[0], it[1], it[2]);
     }
-    for (const auto &it: m_remeshedTriangles) {
-        fprintf(fp, "f %zu %zu %zu\n",
-            it[0] + 1, it[1] + 1, it[2] + 1);
+    for (size_t i = 0; i + 2 < m_remeshedTriangleIndices.size(); i += 3) {
+        fprintf(fp, "f %u %u %u\n",
+            (unsigned int)m_remeshedTriangleIndices[i] + 1, 
+            (unsigned int)m_remeshedTriangleIndices[i + 1] + 1, 
+            (unsigned int)m_remeshedTriangleIndices[i + 2] + 1);
     }
     fclose(fp);
 }
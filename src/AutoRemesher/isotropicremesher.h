@@ -21,6 +21,11 @@
  */
 #ifndef AUTO_REMESHER_ISOTROPIC_REMESHER_H
 #define AUTO_REMESHER_ISOTROPIC_REMESHER_H
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <AutoRemesher/Vector3>
+#include <AutoRemesher/ArrayView>
 
 namespace AutoRemesher
 {
@@ -28,10 +33,32 @@ namespace AutoRemesher
 class IsotropicRemesher
 {
 public:
-    IsotropicRemesher(const std::vector<Vector3> &vertices,
-            std::vector<std::vector<size_t>> &triangles) :
+    // The input mesh after degenerate face removal, with the dihedral angle of every edge cached,
+    // so it can be remeshed repeatedly on different edge lengths and sharp edge degrees
+    class PreprocessedMesh
+    {
+    public:
+        PreprocessedMesh(ArrayView<Vector3> vertices,
+            ArrayView<uint32_t> triangleIndices);
+        ~PreprocessedMesh();
+        double area() const;
+        size_t vertexCount() const;
+    private:
+        friend class IsotropicRemesher;
+        struct Data;
+        Data *m_data = nullptr;
+    };
+    
+    // The buffers are viewed, not copied, they have to outlive remesh()
+    IsotropicRemesher(ArrayView<Vector3> vertices,
+            ArrayView<uint32_t> triangleIndices) :
         m_vertices(vertices),
-        m_triangles(triangles)
+        m_triangleIndices(triangleIndices)
+    {
+    }
+    
+    IsotropicRemesher(const PreprocessedMesh *preprocessedMesh) :
+        m_preprocessedMesh(preprocessedMesh)
     {
     }
     
@@ -50,22 +77,24 @@ public:
         return m_remeshedVertices;
     }
     
-    const std::vector<std::vector<size_t>> &remeshedTriangles()
+    // Three indices per triangle
+    const std::vector<uint32_t> &remeshedTriangleIndices()
     {
-        return m_remeshedTriangles;
+        return m_remeshedTriangleIndices;
     }
     
     bool remesh();
     
     void debugExportObj(const char *filename);
 private:
-    std::vector<Vector3> m_vertices;
-    std::vector<std::vector<size_t>> m_triangles;
+    ArrayView<Vector3> m_vertices;
+    ArrayView<uint32_t> m_triangleIndices;
+    const PreprocessedMesh *m_preprocessedMesh = nullptr;
     double m_targetEdgeLength = 0;
     double m_sharpEdgeDegrees = 60;
     int m_remeshIterations = 3;
     std::vector<Vector3> m_remeshedVertices;
-    std::vector<std::vector<size_t>> m_remeshedTriangles;
+    std::vector<uint32_t> m_remeshedTriangleIndices;
 };
     
 }
@@ -0,0 +1,356 @@
+/*
+ *  Copyright (c) 2020 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <unordered_map>
+#include <Eigen/Dense>
+#include <AutoRemesher/MirrorSymmetry>
+
+namespace AutoRemesher
+{
+
+// Undirected edge keys, sorted, of the edges used by a single polygon
+static void collectBoundaryEdges(ArrayView<uint32_t> polygonIndices, size_t polygonSize, 
+    std::vector<uint64_t> *boundaryEdges)
+{
+    std::vector<uint64_t> edges;
+    edges.reserve(polygonIndices.size());
+    for (size_t i = 0; i + polygonSize - 1 < polygonIndices.size(); i += polygonSize) {
+        for (size_t j = 0; j < polygonSize; ++j) {
+            uint64_t from = polygonIndices[i + j];
+            uint64_t to = polygonIndices[i + (j + 1) % polygonSize];
+            edges.push_back(from < to ? ((from << 32) | to) : ((to << 32) | from));
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    boundaryEdges->clear();
+    for (size_t i = 0; i < edges.size(); ) {
+        size_t end = i + 1;
+        while (end < edges.size() && edges[end] == edges[i])
+            ++end;
+        if (1 == end - i)
+            boundaryEdges->push_back(edges[i]);
+        i = end;
+    }
+}
+
+static Vector3 centroid(ArrayView<Vector3> vertices)
+{
+    Vector3 sum;
+    for (const auto &it: vertices)
+        sum += it;
+    return vertices.empty() ? sum : sum / (double)vertices.size();
+}
+
+MirrorSymmetry MirrorSymmetry::throughCentroid(ArrayView<Vector3> vertices, const Vector3 &normal)
+{
+    Vector3 unitNormal = normal.normalized();
+    return MirrorSymmetry(unitNormal, Vector3::dotProduct(unitNormal, centroid(vertices)));
+}
+
+bool MirrorSymmetry::detect(ArrayView<Vector3> vertices, double tolerance, MirrorSymmetry *symmetry)
+{
+    if (vertices.empty())
+        return false;
+    
+    // The mirror plane of a symmetric vertex set passes through the centroid and its normal is one of the
+    // principal axes, the coordinate planes come first since modelled parts are mostly aligned to them
+    std::vector<Vector3> normals = {
+        Vector3(1.0, 0.0, 0.0),
+        Vector3(0.0, 1.0, 0.0),
+        Vector3(0.0, 0.0, 1.0)
+    };
+    Vector3 center = centroid(vertices);
+    Eigen::Matrix3d covariance = Eigen::Matrix3d::Zero();
+    for (const auto &it: vertices) {
+        Eigen::Vector3d offset(it.x() - center.x(), it.y() - center.y(), it.z() - center.z());
+        covariance += offset * offset.transpose();
+    }
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(covariance);
+    for (int axis = 2; axis >= 0; --axis) {
+        Eigen::Vector3d column = solver.eigenvectors().col(axis);
+        Vector3 normal(column.x(), column.y(), column.z());
+        bool tried = false;
+        for (const auto &it: normals)
+            tried = tried || std::abs(Vector3::dotProduct(it, normal)) > 1.0 - 1e-6;
+        if (!tried)
+            normals.push_back(normal);
+    }
+    
+    for (const auto &normal: normals) {
+        MirrorSymmetry candidate(normal, Vector3::dotProduct(normal.normalized(), center));
+        if (candidate.isSymmetric(vertices, tolerance)) {
+            *symmetry = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MirrorSymmetry::isSymmetric(ArrayView<Vector3> vertices, double tolerance) const
+{
+    // Every reflected vertex looks for a vertex in the cells around it, cells are as wide as the tolerance
+    auto cellKey = [&](const Vector3 &point) {
+        int64_t x = (int64_t)std::floor(point.x() / tolerance);
+        int64_t y = (int64_t)std::floor(point.y() / tolerance);
+        int64_t z = (int64_t)std::floor(point.z() / tolerance);
+        return (uint64_t)((x * 73856093) ^ (y * 19349663) ^ (z * 83492791));
+    };
+    std::unordered_multimap<uint64_t, size_t> cells;
+    cells.reserve(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i)
+        cells.insert({cellKey(vertices[i]), i});
+    for (const auto &it: vertices) {
+        Vector3 reflected = reflect(it);
+        bool found = false;
+        for (int dx = -1; !found && dx <= 1; ++dx) {
+            for (int dy = -1; !found && dy <= 1; ++dy) {
+                for (int dz = -1; !found && dz <= 1; ++dz) {
+                    auto range = cells.equal_range(cellKey(reflected + Vector3(dx, dy, dz) * tolerance));
+                    for (auto cell = range.first; !found && cell != range.second; ++cell)
+                        found = (vertices[cell->second] - reflected).length() <= tolerance;
+                }
+            }
+        }
+        if (!found)
+            return false;
+    }
+    return true;
+}
+
+size_t MirrorSymmetry::boundaryLoopCount(ArrayView<uint32_t> polygonIndices, size_t polygonSize)
+{
+    std::vector<uint64_t> boundaryEdges;
+    collectBoundaryEdges(polygonIndices, polygonSize, &boundaryEdges);
+    
+    // Union find over the vertices of the boundary edges, numbered by their place in the sorted list
+    std::vector<uint32_t> boundaryVertices;
+    boundaryVertices.reserve(boundaryEdges.size() * 2);
+    for (const auto &it: boundaryEdges) {
+        boundaryVertices.push_back((uint32_t)(it >> 32));
+        boundaryVertices.push_back((uint32_t)(it & 0xffffffff));
+    }
+    std::sort(boundaryVertices.begin(), boundaryVertices.end());
+    boundaryVertices.erase(std::unique(boundaryVertices.begin(), boundaryVertices.end()), boundaryVertices.end());
+    auto number = [&](uint32_t vertex) {
+        return (size_t)(std::lower_bound(boundaryVertices.begin(), boundaryVertices.end(), vertex) - boundaryVertices.begin());
+    };
+    std::vector<size_t> parents(boundaryVertices.size());
+    for (size_t i = 0; i < parents.size(); ++i)
+        parents[i] = i;
+    auto findRoot = [&](size_t i) {
+        while (parents[i] != i) {
+            parents[i] = parents[parents[i]];
+            i = parents[i];
+        }
+        return i;
+    };
+    size_t loopCount = boundaryVertices.size();
+    for (const auto &it: boundaryEdges) {
+        size_t first = findRoot(number((uint32_t)(it >> 32)));
+        size_t second = findRoot(number((uint32_t)(it & 0xffffffff)));
+        if (first == second)
+            continue;
+        parents[first] = second;
+        --loopCount;
+    }
+    return loopCount;
+}
+
+size_t MirrorSymmetry::seamBoundaryEdgeCount(ArrayView<Vector3> vertices, ArrayView<uint32_t> quadIndices, double distance) const
+{
+    std::vector<uint64_t> boundaryEdges;
+    collectBoundaryEdges(quadIndices, 4, &boundaryEdges);
+    size_t seamEdgeCount = 0;
+    for (const auto &it: boundaryEdges) {
+        const Vector3 &from = vertices[it >> 32];
+        const Vector3 &to = vertices[it & 0xffffffff];
+        if (std::abs(signedDistance(from)) > distance || std::abs(signedDistance(to)) > distance)
+            continue;
+        if (std::abs(Vector3::dotProduct((to - from).normalized(), m_normal)) < 0.5)
+            ++seamEdgeCount;
+    }
+    return seamEdgeCount;
+}
+
+bool MirrorSymmetry::cut(ArrayView<Vector3> vertices, ArrayView<uint32_t> triangleIndices, double snapDistance,
+    std::vector<Vector3> *halfVertices, std::vector<uint32_t> *halfTriangleIndices)
+{
+    halfVertices->clear();
+    halfTriangleIndices->clear();
+    m_boundaryLoopCount = boundaryLoopCount(triangleIndices, 3);
+    
+    std::vector<double> distances(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        double distance = signedDistance(vertices[i]);
+        distances[i] = std::abs(distance) <= snapDistance ? 0.0 : distance;
+    }
+    
+    const uint32_t unmappedVertex = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> oldToNewVertexMap(vertices.size(), unmappedVertex);
+    auto keepVertex = [&](uint32_t index) {
+        uint32_t &newIndex = oldToNewVertexMap[index];
+        if (unmappedVertex == newIndex) {
+            newIndex = (uint32_t)halfVertices->size();
+            const Vector3 &position = vertices[index];
+            halfVertices->push_back(0.0 == distances[index] ? position - m_normal * signedDistance(position) : position);
+        }
+        return newIndex;
+    };
+    
+    // Crossing points are keyed by their undirected edge, so both triangles of an edge share the new vertex
+    std::unordered_map<uint64_t, uint32_t> crossingVertices;
+    auto crossVertex = [&](uint32_t from, uint32_t to) {
+        uint64_t key = from < to ? (((uint64_t)from << 32) | to) : (((uint64_t)to << 32) | from);
+        auto insertResult = crossingVertices.insert({key, (uint32_t)halfVertices->size()});
+        if (insertResult.second) {
+            double t = distances[from] / (distances[from] - distances[to]);
+            Vector3 position = vertices[from] + (vertices[to] - vertices[from]) * t;
+            halfVertices->push_back(position - m_normal * signedDistance(position));
+        }
+        return insertResult.first->second;
+    };
+    
+    bool dropped = false;
+    for (size_t k = 0; k + 2 < triangleIndices.size(); k += 3) {
+        const uint32_t *face = &triangleIndices[k];
+        size_t positiveCount = 0;
+        size_t negativeCount = 0;
+        for (size_t i = 0; i < 3; ++i) {
+            if (distances[face[i]] > 0.0)
+                ++positiveCount;
+            else if (distances[face[i]] < 0.0)
+                ++negativeCount;
+        }
+        if (0 == positiveCount) {
+            dropped = true;
+            continue;
+        }
+        if (0 == negativeCount) {
+            for (size_t i = 0; i < 3; ++i)
+                halfTriangleIndices->push_back(keepVertex(face[i]));
+            continue;
+        }
+        
+        // Walk the triangle keeping the corners on the plane or the positive side and the crossing points,
+        // which leaves a triangle or a quad
+        dropped = true;
+        uint32_t polygon[4];
+        size_t cornerCount = 0;
+        for (size_t i = 0; i < 3; ++i) {
+            uint32_t from = face[i];
+            uint32_t to = face[(i + 1) % 3];
+            if (distances[from] >= 0.0)
+                polygon[cornerCount++] = keepVertex(from);
+            if ((distances[from] > 0.0 && distances[to] < 0.0) || (distances[from] < 0.0 && distances[to] > 0.0))
+                polygon[cornerCount++] = crossVertex(from, to);
+        }
+        for (size_t i = 1; i + 1 < cornerCount; ++i) {
+            halfTriangleIndices->push_back(polygon[0]);
+            halfTriangleIndices->push_back(polygon[i]);
+            halfTriangleIndices->push_back(polygon[i + 1]);
+        }
+    }
+    return dropped && !halfTriangleIndices->empty();
+}
+
+bool MirrorSymmetry::mirror(std::vector<Vector3> *vertices, std::vector<uint32_t> *quadIndices) const
+{
+    auto &positions = *vertices;
+    auto &quads = *quadIndices;
+    if (quads.empty())
+        return true;
+    
+    double edgeLengthSum = 0.0;
+    for (size_t i = 0; i + 3 < quads.size(); i += 4) {
+        for (size_t j = 0; j < 4; ++j)
+            edgeLengthSum += (positions[quads[i + (j + 1) % 4]] - positions[quads[i + j]]).length();
+    }
+    double weldDistance = 0.5 * edgeLengthSum / quads.size();
+    
+    size_t keptSize = 0;
+    for (size_t i = 0; i + 3 < quads.size(); i += 4) {
+        bool inPlane = true;
+        for (size_t j = 0; inPlane && j < 4; ++j)
+            inPlane = std::abs(signedDistance(positions[quads[i + j]])) <= weldDistance;
+        if (inPlane) {
+            // Thin quads along the cut are near the plane as well, but they stand across it
+            Vector3 quadNormal = Vector3::normal(positions[quads[i]], positions[quads[i + 1]], positions[quads[i + 2]]) +
+                Vector3::normal(positions[quads[i + 2]], positions[quads[i + 3]], positions[quads[i]]);
+            if (std::abs(Vector3::dotProduct(quadNormal.normalized(), m_normal)) > 0.9)
+                continue;
+        }
+        for (size_t j = 0; j < 4; ++j)
+            quads[keptSize + j] = quads[i + j];
+        keptSize += 4;
+    }
+    quads.resize(keptSize);
+    
+    std::vector<bool> referenced(positions.size(), false);
+    for (const auto &it: quads)
+        referenced[it] = true;
+    std::vector<uint64_t> boundaryEdges;
+    collectBoundaryEdges(quads, 4, &boundaryEdges);
+    std::vector<bool> boundary(positions.size(), false);
+    for (const auto &it: boundaryEdges) {
+        boundary[it >> 32] = true;
+        boundary[it & 0xffffffff] = true;
+    }
+    
+    const uint32_t unmappedVertex = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> mirroredVertices(positions.size(), unmappedVertex);
+    size_t vertexCount = positions.size();
+    for (size_t i = 0; i < vertexCount; ++i) {
+        if (!referenced[i])
+            continue;
+        Vector3 position = positions[i];
+        double distance = signedDistance(position);
+        if (boundary[i] && std::abs(distance) <= weldDistance) {
+            positions[i] = position - m_normal * distance;
+            mirroredVertices[i] = (uint32_t)i;
+            continue;
+        }
+        mirroredVertices[i] = (uint32_t)positions.size();
+        positions.push_back(reflect(position));
+    }
+    
+    quads.reserve(keptSize * 2);
+    for (size_t i = 0; i + 3 < keptSize; i += 4) {
+        quads.push_back(mirroredVertices[quads[i]]);
+        quads.push_back(mirroredVertices[quads[i + 3]]);
+        quads.push_back(mirroredVertices[quads[i + 2]]);
+        quads.push_back(mirroredVertices[quads[i + 1]]);
+    }
+    
+    // A seam vertex the remesh left further from the plane than the weld distance got a mirrored twin
+    // instead of being shared, which opens a crack along the plane and changes the boundary loops
+    if (boundaryLoopCount(quads, 4) != m_boundaryLoopCount ||
+            0 != seamBoundaryEdgeCount(positions, quads, 2.0 * weldDistance)) {
+        positions.clear();
+        quads.clear();
+        return false;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,99 @@
+/*
+ *  Copyright (c) 2020 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+#ifndef AUTO_REMESHER_MIRROR_SYMMETRY_H
+#define AUTO_REMESHER_MIRROR_SYMMETRY_H
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <AutoRemesher/Vector3>
+#include <AutoRemesher/ArrayView>
+
+namespace AutoRemesher
+{
+
+// A mirror plane of an island, the points where dot(normal, point) equals the offset. The half on the
+// positive side is kept by cut(), remeshed alone, and mirror() rebuilds the other half from its quads
+class MirrorSymmetry
+{
+public:
+    MirrorSymmetry() = default;
+    
+    MirrorSymmetry(const Vector3 &normal, double offset) :
+        m_normal(normal.normalized()),
+        m_offset(offset)
+    {
+    }
+    
+    // The plane with the given normal through the centroid of the vertices
+    static MirrorSymmetry throughCentroid(ArrayView<Vector3> vertices, const Vector3 &normal);
+    
+    // Tries the coordinate planes, then the principal planes, all through the centroid, and takes the
+    // first one every vertex mirrors onto another vertex within the tolerance
+    static bool detect(ArrayView<Vector3> vertices, double tolerance, MirrorSymmetry *symmetry);
+    
+    bool isSymmetric(ArrayView<Vector3> vertices, double tolerance) const;
+    
+    // Keeps the triangles on the positive side, triangles across the plane are clipped on it, so the cut is
+    // an open boundary lying in the plane. Vertices closer than the snap distance are moved onto the plane.
+    // The boundary loops of the whole island are counted, for mirror() to check the weld against.
+    // False when the plane doesn't split the island
+    bool cut(ArrayView<Vector3> vertices, ArrayView<uint32_t> triangleIndices, double snapDistance,
+        std::vector<Vector3> *halfVertices, std::vector<uint32_t> *halfTriangleIndices);
+    
+    // Appends the mirror image of the half remeshed quads, with the winding reversed. The half is parameterized
+    // with the cut on an integer isoline, so its quads end on the plane up to rounding. Boundary vertices within
+    // half an average edge of the plane are snapped onto it and shared by both halves, quads lying in the plane,
+    // like a patch closing the cut, are dropped. The weld is still checked: false, with both arrays cleared,
+    // when the result has another boundary loop count than the whole island had, or boundary edges left along
+    // the plane
+    bool mirror(std::vector<Vector3> *vertices, std::vector<uint32_t> *quadIndices) const;
+    
+    // Boundary edges of the quads within the distance of the plane and running along it, cracks between
+    // halves which were not welded. Boundary edges crossing the plane, like the rim of an open part, don't count
+    size_t seamBoundaryEdgeCount(ArrayView<Vector3> vertices, ArrayView<uint32_t> quadIndices, double distance) const;
+    
+    // Connected boundary loops of a triangle (polygon size 3) or quad (4) mesh
+    static size_t boundaryLoopCount(ArrayView<uint32_t> polygonIndices, size_t polygonSize);
+    
+    double signedDistance(const Vector3 &point) const
+    {
+        return Vector3::dotProduct(m_normal, point) - m_offset;
+    }
+    
+    Vector3 reflect(const Vector3 &point) const
+    {
+        return point - m_normal * (2.0 * signedDistance(point));
+    }
+    
+    const Vector3 &normal() const
+    {
+        return m_normal;
+    }
+private:
+    Vector3 m_normal = Vector3(1.0, 0.0, 0.0);
+    double m_offset = 0.0;
+    size_t m_boundaryLoopCount = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,177 @@
+/*
+ *  Copyright (c) 2020 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+#include <cmath>
+#include <map>
+#include <algorithm>
+#include <AutoRemesher/PairingQuadRemesher>
+#include <AutoRemesher/Tracer>
+
+namespace AutoRemesher
+{
+
+const double PairingQuadRemesher::m_maxPairingDihedralDegrees = 40.0;
+
+bool PairingQuadRemesher::remesh()
+{
+    Tracer::ScopedEvent event("PairingQuadRemesher::remesh");
+    
+    m_remeshedVertices.clear();
+    m_remeshedQuadIndices.clear();
+    size_t triangleCount = m_triangleIndices.size() / 3;
+    if (0 == triangleCount)
+        return false;
+    
+    std::vector<Vector3> faceNormals(triangleCount);
+    for (size_t i = 0; i < triangleCount; ++i) {
+        const uint32_t *face = &m_triangleIndices[i * 3];
+        faceNormals[i] = Vector3::crossProduct(m_vertices[face[1]] - m_vertices[face[0]], 
+            m_vertices[face[2]] - m_vertices[face[0]]).normalized();
+    }
+    
+    // Half edges keyed by the undirected edge, an edge with exactly two opposite half edges can be merged away
+    struct HalfEdgeRecord
+    {
+        uint64_t edge;
+        uint32_t face;
+        uint32_t corner;
+    };
+    std::vector<HalfEdgeRecord> records;
+    records.reserve(triangleCount * 3);
+    for (size_t i = 0; i < triangleCount; ++i) {
+        const uint32_t *face = &m_triangleIndices[i * 3];
+        for (uint32_t j = 0; j < 3; ++j) {
+            uint64_t from = face[j];
+            uint64_t to = face[(j + 1) % 3];
+            records.push_back({from < to ? ((from << 32) | to) : ((to << 32) | from), (uint32_t)i, j});
+        }
+    }
+    std::sort(records.begin(), records.end(), [](const HalfEdgeRecord &first, const HalfEdgeRecord &second) {
+        return first.edge < second.edge;
+    });
+    
+    struct Pairing
+    {
+        double score;
+        uint32_t quad[4];
+        uint32_t faces[2];
+    };
+    std::vector<Pairing> pairings;
+    const double minNormalCosine = std::cos(m_maxPairingDihedralDegrees * M_PI / 180.0);
+    for (size_t i = 0; i + 1 < records.size(); ++i) {
+        const auto &first = records[i];
+        const auto &second = records[i + 1];
+        if (first.edge != second.edge || first.face == second.face ||
+                (i + 2 < records.size() && records[i + 2].edge == first.edge) ||
+                (i > 0 && records[i - 1].edge == first.edge))
+            continue;
+        const uint32_t *firstFace = &m_triangleIndices[first.face * 3];
+        const uint32_t *secondFace = &m_triangleIndices[second.face * 3];
+        // The first face is (a, b, c) with the shared edge a->b, the second one runs b->a and adds d
+        uint32_t a = firstFace[first.corner];
+        uint32_t b = firstFace[(first.corner + 1) % 3];
+        uint32_t c = firstFace[(first.corner + 2) % 3];
+        if (secondFace[second.corner] != b)
+            continue;
+        uint32_t d = secondFace[(second.corner + 2) % 3];
+        double normalCosine = Vector3::dotProduct(faceNormals[first.face], faceNormals[second.face]);
+        if (normalCosine < minNormalCosine)
+            continue;
+        Pairing pairing = {0.0, {b, c, a, d}, {first.face, second.face}};
+        // Convex and as close to a rectangle as possible, the worst corner decides
+        Vector3 quadNormal = faceNormals[first.face] + faceNormals[second.face];
+        double worstCornerCosine = 0.0;
+        bool convex = true;
+        for (size_t k = 0; k < 4; ++k) {
+            const Vector3 &corner = m_vertices[pairing.quad[k]];
+            Vector3 toNext = m_vertices[pairing.quad[(k + 1) % 4]] - corner;
+            Vector3 toPrevious = m_vertices[pairing.quad[(k + 3) % 4]] - corner;
+            if (Vector3::dotProduct(Vector3::crossProduct(toNext, toPrevious), quadNormal) <= 0.0) {
+                convex = false;
+                break;
+            }
+            worstCornerCosine = std::max(worstCornerCosine, 
+                std::abs(Vector3::dotProduct(toNext.normalized(), toPrevious.normalized())));
+        }
+        if (!convex)
+            continue;
+        pairing.score = worstCornerCosine + (1.0 - normalCosine);
+        pairings.push_back(pairing);
+    }
+    std::sort(pairings.begin(), pairings.end(), [](const Pairing &first, const Pairing &second) {
+        return first.score < second.score;
+    });
+    
+    std::vector<bool> paired(triangleCount, false);
+    std::vector<std::vector<uint32_t>> faces;
+    for (const auto &pairing: pairings) {
+        if (paired[pairing.faces[0]] || paired[pairing.faces[1]])
+            continue;
+        paired[pairing.faces[0]] = paired[pairing.faces[1]] = true;
+        faces.push_back(std::vector<uint32_t>(pairing.quad, pairing.quad + 4));
+    }
+    size_t quadCount = faces.size();
+    for (size_t i = 0; i < triangleCount; ++i) {
+        if (!paired[i])
+            faces.push_back(std::vector<uint32_t>(&m_triangleIndices[i * 3], &m_triangleIndices[i * 3] + 3));
+    }
+    
+    if (quadCount == faces.size()) {
+        m_remeshedVertices.assign(m_vertices.begin(), m_vertices.end());
+        for (const auto &face: faces)
+            m_remeshedQuadIndices.insert(m_remeshedQuadIndices.end(), face.begin(), face.end());
+    } else {
+        splitFaces(faces);
+    }
+    return true;
+}
+
+void PairingQuadRemesher::splitFaces(const std::vector<std::vector<uint32_t>> &faces)
+{
+    // One quad per face corner: the corner, the middle of the next edge, the face center and the middle
+    // of the previous edge. Edge middles are shared, so neighbor faces still line up
+    m_remeshedVertices.assign(m_vertices.begin(), m_vertices.end());
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t> edgeMiddles;
+    auto edgeMiddle = [&](uint32_t from, uint32_t to) {
+        auto key = from < to ? std::make_pair(from, to) : std::make_pair(to, from);
+        auto insertResult = edgeMiddles.insert({key, (uint32_t)m_remeshedVertices.size()});
+        if (insertResult.second)
+            m_remeshedVertices.push_back(0.5 * (m_vertices[from] + m_vertices[to]));
+        return insertResult.first->second;
+    };
+    for (const auto &face: faces) {
+        Vector3 center;
+        for (const auto &index: face)
+            center += m_vertices[index];
+        uint32_t centerIndex = (uint32_t)m_remeshedVertices.size();
+        m_remeshedVertices.push_back(center / face.size());
+        for (size_t i = 0; i < face.size(); ++i) {
+            uint32_t previous = face[(i + face.size() - 1) % face.size()];
+            uint32_t next = face[(i + 1) % face.size()];
+            m_remeshedQuadIndices.push_back(face[i]);
+            m_remeshedQuadIndices.push_back(edgeMiddle(face[i], next));
+            m_remeshedQuadIndices.push_back(centerIndex);
+            m_remeshedQuadIndices.push_back(edgeMiddle(previous, face[i]));
+        }
+    }
+}
+
+}
@@ -0,0 +1,73 @@
+/*
+ *  Copyright (c) 2020 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+#ifndef AUTO_REMESHER_PAIRING_QUAD_REMESHER_H
+#define AUTO_REMESHER_PAIRING_QUAD_REMESHER_H
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <AutoRemesher/Vector3>
+#include <AutoRemesher/ArrayView>
+
+namespace AutoRemesher
+{
+
+// Quads straight from the input triangles, by merging neighbor pairs greedily from the best shaped quad down.
+// Meant for islands too small to be worth a parameterization: rivets, screws, buttons. When some triangles
+// are left unpaired, every face is split once more around its center, so the result is still all quads
+class PairingQuadRemesher
+{
+public:
+    // The buffers are viewed, not copied, they have to outlive remesh()
+    PairingQuadRemesher(ArrayView<Vector3> vertices,
+            ArrayView<uint32_t> triangleIndices) :
+        m_vertices(vertices),
+        m_triangleIndices(triangleIndices)
+    {
+    }
+    
+    const std::vector<Vector3> &remeshedVertices()
+    {
+        return m_remeshedVertices;
+    }
+    
+    // Four indices per quad
+    const std::vector<uint32_t> &remeshedQuadIndices()
+    {
+        return m_remeshedQuadIndices;
+    }
+    
+    bool remesh();
+    
+    // Neighbor triangles bent further than this are not merged
+    static const double m_maxPairingDihedralDegrees;
+private:
+    ArrayView<Vector3> m_vertices;
+    ArrayView<uint32_t> m_triangleIndices;
+    std::vector<Vector3> m_remeshedVertices;
+    std::vector<uint32_t> m_remeshedQuadIndices;
+    
+    void splitFaces(const std::vector<std::vector<uint32_t>> &faces);
+};
+
+}
+
+#endif
@@ -21,7 +21,10 @@
  */
 #include <AutoRemesher/Parameterizer>
 #include <iostream>
+#include <limits>
 #include <unordered_set>
+#include <AutoRemesher/Tracer>
+#include <tbb/parallel_sort.h>
 #if AUTO_REMESHER_DEBUG
 #include <QDebug>
 #endif
@@ -34,105 +37,199 @@ Parameterizer::Parameterizer(HalfEdge::Mesh *mesh, const Parameters &parameters)
 {
     m_mesh = mesh;
     
-    m_V = new Eigen::MatrixXd(m_mesh->vertexCount(), 3);
-    m_F = new Eigen::MatrixXi(m_mesh->faceCount(), 3);
+    // Compacted, the vertex and face indices are the rows of V and F
+    m_mesh->compact();
+    const auto &vertices = m_mesh->vertices();
+    const auto &faces = m_mesh->faces();
+    const auto &halfEdges = m_mesh->halfEdges();
     
-    size_t vertexNum = 0;
-    for (HalfEdge::Vertex *vertex = m_mesh->firstVertex(); nullptr != vertex; vertex = vertex->_next) {
-        vertex->outputIndex = vertexNum;
-        m_V->row(vertexNum++) << 
-            vertex->position.x(), 
-            vertex->position.y(), 
-            vertex->position.z();
+    m_V = new Eigen::MatrixXd(vertices.size(), 3);
+    m_F = new Eigen::MatrixXi(faces.size(), 3);
+    
+    for (size_t vertexNum = 0; vertexNum < vertices.size(); ++vertexNum) {
+        const auto &position = vertices[vertexNum].position;
+        m_V->row(vertexNum) << 
+            position.x(), 
+            position.y(), 
+            position.z();
     }
     
-    size_t faceNum = 0;
-    for (HalfEdge::Face *face = m_mesh->firstFace(); nullptr != face; face = face->_next) {
-        HalfEdge::HalfEdge *h0 = face->anyHalfEdge;
-        HalfEdge::HalfEdge *h1 = h0->nextHalfEdge;
-        HalfEdge::HalfEdge *h2 = h1->nextHalfEdge;
+    for (size_t faceNum = 0; faceNum < faces.size(); ++faceNum) {
+        const HalfEdge::HalfEdge &h0 = halfEdges[faces[faceNum].anyHalfEdge];
+        const HalfEdge::HalfEdge &h1 = halfEdges[h0.nextHalfEdge];
+        const HalfEdge::HalfEdge &h2 = halfEdges[h1.nextHalfEdge];
         m_F->row(faceNum) << 
-            h0->startVertex->outputIndex, 
-            h1->startVertex->outputIndex, 
-            h2->startVertex->outputIndex;
-        ++faceNum;
+            h0.startVertex, 
+            h1.startVertex, 
+            h2.startVertex;
     }
     
     m_PD1 = new Eigen::MatrixXd;
     m_PD2 = new Eigen::MatrixXd;
     Eigen::MatrixXd PV1, PV2;
-    igl::principal_curvature(*m_V, *m_F, *m_PD1, *m_PD2, PV1, PV2);
+    {
+        Tracer::ScopedEvent event("igl::principal_curvature");
+        igl::principal_curvature(*m_V, *m_F, m_mesh->vertexNeighborOffsets(), m_mesh->vertexNeighbors(), 
+            *m_PD1, *m_PD2, PV1, PV2);
+    }
     
-    m_mesh->orderVertexByFlatness();
+    // Sorted once, a constraint ratio is then a position in the array
+    m_sortedRelativeHeights.resize(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i)
+        m_sortedRelativeHeights[i] = vertices[i].relativeHeight;
+    tbb::parallel_sort(m_sortedRelativeHeights.begin(), m_sortedRelativeHeights.end());
+    
+    prepareConstraintEvents();
+    if (nullptr != m_parameters.symmetry)
+        collectSeamEdges(*m_parameters.symmetry);
 }
 
-double Parameterizer::calculateLimitRelativeHeight(double constraintRatio)
+void Parameterizer::collectSeamEdges(const MirrorSymmetry &symmetry)
 {
-    size_t targetConstraintVertexCount = m_mesh->vertexCount() * constraintRatio;
-    size_t constaintVertexCount = 0;
-    double limitRelativeHeight = 0.2;
-    if (targetConstraintVertexCount > 0) {
-        for (const auto &it: m_mesh->vertexOrderedByFlatness()) {
-            limitRelativeHeight = it->relativeHeight;
-            ++constaintVertexCount;
-            if (constaintVertexCount >= targetConstraintVertexCount)
+    // The cut puts its vertices onto the plane and the isotropic remesh never moves the border,
+    // so the seam lies in the plane up to rounding
+    double tolerance = 1e-6 * igl::avg_edge_length(*m_V, *m_F);
+    const auto &vertices = m_mesh->vertices();
+    const auto &faces = m_mesh->faces();
+    const auto &halfEdges = m_mesh->halfEdges();
+    m_seamEdges.clear();
+    for (size_t faceNum = 0; faceNum < faces.size(); ++faceNum) {
+        HalfEdge::Index halfEdge = faces[faceNum].anyHalfEdge;
+        for (int8_t corner = 0; corner < 3; ++corner) {
+            const auto &it = halfEdges[halfEdge];
+            const Vector3 &from = vertices[it.startVertex].position;
+            const Vector3 &to = vertices[halfEdges[it.nextHalfEdge].startVertex].position;
+            if (HalfEdge::InvalidIndex == it.oppositeHalfEdge &&
+                    std::abs(symmetry.signedDistance(from)) <= tolerance &&
+                    std::abs(symmetry.signedDistance(to)) <= tolerance) {
+                Vector3 direction = (to - from).normalized();
+                Vector3 across = Vector3::crossProduct(Vector3::normal(vertices[(*m_F)(faceNum, 0)].position,
+                    vertices[(*m_F)(faceNum, 1)].position,
+                    vertices[(*m_F)(faceNum, 2)].position), direction);
+                // A degenerate face has no frame to give, it keeps the curvature one
+                if (!across.isZero())
+                    m_seamEdges.push_back({(uint32_t)faceNum, corner, direction, across.normalized()});
                 break;
+            }
+            halfEdge = it.nextHalfEdge;
         }
     }
-    return limitRelativeHeight;
+}
+
+void Parameterizer::prepareConstraintEvents()
+{
+    // A corner can only constrain its face when both principal directions are defined
+    const auto &vertices = m_mesh->vertices();
+    std::vector<double> constraintHeights(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        auto r1 = m_PD1->row(i);
+        auto r2 = m_PD2->row(i);
+        if (Vector3(r1.x(), r1.y(), r1.z()).isZero() || Vector3(r2.x(), r2.y(), r2.z()).isZero())
+            constraintHeights[i] = std::numeric_limits<double>::infinity();
+        else
+            constraintHeights[i] = vertices[i].relativeHeight;
+    }
+    
+    // Raising the limit lets the corners of a face in by height, each one which comes before the
+    // corner in use takes over, so a face has at most three events, at strictly rising heights
+    m_constraintEvents.clear();
+    m_constraintEvents.reserve(m_F->rows());
+    for (int face = 0; face < m_F->rows(); ++face) {
+        int order[3] = {0, 1, 2};
+        double heights[3];
+        for (int corner = 0; corner < 3; ++corner)
+            heights[corner] = constraintHeights[(*m_F)(face, corner)];
+        std::sort(order, order + 3, [&](int first, int second) {
+            if (heights[first] != heights[second])
+                return heights[first] < heights[second];
+            return first < second;
+        });
+        int8_t corner = -1;
+        for (const auto &it: order) {
+            if (std::isinf(heights[it]))
+                break;
+            if (-1 != corner && it > corner)
+                continue;
+            m_constraintEvents.push_back({heights[it], (uint32_t)face, (int8_t)it, corner});
+            corner = (int8_t)it;
+        }
+    }
+    tbb::parallel_sort(m_constraintEvents.begin(), m_constraintEvents.end(), 
+            [](const ConstraintEvent &first, const ConstraintEvent &second) {
+        if (first.relativeHeight != second.relativeHeight)
+            return first.relativeHeight < second.relativeHeight;
+        return first.face < second.face;
+    });
+    m_constraintCorners.assign(m_F->rows(), -1);
+    m_appliedConstraintEventCount = 0;
+    m_constraintCount = 0;
+}
+
+double Parameterizer::calculateLimitRelativeHeight(double constraintRatio)
+{
+    size_t targetConstraintVertexCount = m_sortedRelativeHeights.size() * constraintRatio;
+    if (0 == targetConstraintVertexCount)
+        return 0.2;
+    return m_sortedRelativeHeights[std::min(targetConstraintVertexCount, m_sortedRelativeHeights.size()) - 1];
 }
 
 void Parameterizer::prepareConstraints(double limitRelativeHeight)
 {
-    std::vector<int> constraintFaces;
-    std::vector<Vector3> constaintDirections1;
-    std::vector<Vector3> constaintDirections2;
+    if (nullptr != m_b && limitRelativeHeight == m_preparedLimitRelativeHeight)
+        return;
+    m_preparedLimitRelativeHeight = limitRelativeHeight;
     
-    size_t faceNum = 0;
-    for (HalfEdge::Face *face = m_mesh->firstFace(); nullptr != face; face = face->_next) {
-        HalfEdge::HalfEdge *h0 = face->anyHalfEdge;
-        HalfEdge::HalfEdge *h1 = h0->nextHalfEdge;
-        HalfEdge::HalfEdge *h2 = h1->nextHalfEdge;
-        
-        auto addFeatured = [&](HalfEdge::HalfEdge *h) {
-            if (h->startVertex->relativeHeight > limitRelativeHeight)
-                return false;
-  
-            auto r1 = m_PD1->row(h->startVertex->outputIndex);
-            auto r2 = m_PD2->row(h->startVertex->outputIndex);
-            
-            auto v1 = AutoRemesher::Vector3(r1.x(), r1.y(), r1.z());
-            auto v2 = AutoRemesher::Vector3(r2.x(), r2.y(), r2.z());
-            
-            if (v1.isZero() || v2.isZero())
-                return false;
-            
-            constraintFaces.push_back(faceNum);
-            constaintDirections1.push_back(v1);
-            constaintDirections2.push_back(v2);
-            
-            return true;
-        };
-        
-        addFeatured(h0) || addFeatured(h1) || addFeatured(h2);
-        
-        ++faceNum;
+    // Only the faces whose events lie between the previous limit and this one change
+    while (m_appliedConstraintEventCount < m_constraintEvents.size() &&
+            m_constraintEvents[m_appliedConstraintEventCount].relativeHeight <= limitRelativeHeight) {
+        const auto &event = m_constraintEvents[m_appliedConstraintEventCount++];
+        m_constraintCorners[event.face] = event.corner;
+        if (-1 == event.previousCorner)
+            ++m_constraintCount;
+    }
+    while (m_appliedConstraintEventCount > 0 &&
+            m_constraintEvents[m_appliedConstraintEventCount - 1].relativeHeight > limitRelativeHeight) {
+        const auto &event = m_constraintEvents[--m_appliedConstraintEventCount];
+        m_constraintCorners[event.face] = event.previousCorner;
+        if (-1 == event.previousCorner)
+            --m_constraintCount;
     }
     
     delete m_b;
     delete m_bc1;
     delete m_bc2;
     
-    m_b = new Eigen::VectorXi(constraintFaces.size());
-    m_bc1 = new Eigen::MatrixXd(constaintDirections1.size(), 3);
-    m_bc2 = new Eigen::MatrixXd(constaintDirections2.size(), 3);
+    // Faces on the cut of a mirrored half follow the cut, whatever the curvature says
+    size_t rowCount = m_constraintCount;
+    for (const auto &it: m_seamEdges) {
+        if (-1 == m_constraintCorners[it.face])
+            ++rowCount;
+    }
+    
+    m_b = new Eigen::VectorXi(rowCount);
+    m_bc1 = new Eigen::MatrixXd(rowCount, 3);
+    m_bc2 = new Eigen::MatrixXd(rowCount, 3);
     
-    for (size_t i = 0; i < constraintFaces.size(); ++i) {
-        const auto &v1 = constaintDirections1[i];
-        const auto &v2 = constaintDirections2[i];
-        m_b->row(i) << constraintFaces[i];
-        m_bc1->row(i) << v1.x(), v1.y(), v1.z();
-        m_bc2->row(i) << v2.x(), v2.y(), v2.z();
+    // In face order, as the solvers have always been given them
+    size_t row = 0;
+    size_t seamEdgeIndex = 0;
+    for (size_t face = 0; face < m_constraintCorners.size(); ++face) {
+        if (seamEdgeIndex < m_seamEdges.size() && face == m_seamEdges[seamEdgeIndex].face) {
+            const auto &seamEdge = m_seamEdges[seamEdgeIndex++];
+            (*m_b)(row) = (int)face;
+            m_bc1->row(row) << seamEdge.direction.x(), seamEdge.direction.y(), seamEdge.direction.z();
+            m_bc2->row(row) << seamEdge.across.x(), seamEdge.across.y(), seamEdge.across.z();
+            ++row;
+            continue;
+        }
+        int8_t corner = m_constraintCorners[face];
+        if (-1 == corner)
+            continue;
+        int vertex = (*m_F)(face, corner);
+        (*m_b)(row) = (int)face;
+        m_bc1->row(row) = m_PD1->row(vertex);
+        m_bc2->row(row) = m_PD2->row(vertex);
+        ++row;
     }
 }
 
@@ -156,15 +253,23 @@ bool Parameterizer::miq(size_t *singularityCount, bool calculateSingularityOnly)
     Eigen::MatrixXd X1_deformed;
     Eigen::MatrixXd X2_deformed;
     
+    Tracer::ScopedEvent miqEvent(calculateSingularityOnly ? "Parameterizer::miq(singularities)" : "Parameterizer::miq");
+    
     // Interpolate the frame field
-    igl::copyleft::comiso::frame_field(*m_V, *m_F, *m_b, *m_bc1, *m_bc2, FF1, FF2);
+    {
+        Tracer::ScopedEvent event("frame_field");
+        igl::copyleft::comiso::frame_field(*m_V, *m_F, *m_b, *m_bc1, *m_bc2, FF1, FF2);
+    }
 
     // Deform the mesh to transform the frame field in a cross field
-    igl::frame_field_deformer(
-        *m_V, *m_F, FF1, FF2, V_deformed, FF1_deformed, FF2_deformed);
+    {
+        Tracer::ScopedEvent event("frame_field_deformer");
+        igl::frame_field_deformer(
+            *m_V, *m_F, FF1, FF2, V_deformed, FF1_deformed, FF2_deformed);
 
-    // Find the closest crossfield to the deformed frame field
-    igl::frame_to_cross_field(V_deformed, *m_F, FF1_deformed, FF2_deformed, X1_deformed);
+        // Find the closest crossfield to the deformed frame field
+        igl::frame_to_cross_field(V_deformed, *m_F, FF1_deformed, FF2_deformed, X1_deformed);
+    }
 
     // Find a smooth crossfield that interpolates the deformed constraints
     Eigen::MatrixXd bc_x(m_b->size(), 3);
@@ -172,6 +277,7 @@ bool Parameterizer::miq(size_t *singularityCount, bool calculateSingularityOnly)
         bc_x.row(i) = X1_deformed.row((*m_b)(i));
 
     Eigen::VectorXd S;
+    Tracer::ScopedEvent nrosyEvent("nrosy");
     igl::copyleft::comiso::nrosy(
         *m_V,
         *m_F,
@@ -184,6 +290,7 @@ bool Parameterizer::miq(size_t *singularityCount, bool calculateSingularityOnly)
         0.5,
         X1_deformed,
         S);
+    nrosyEvent.finish();
 
     // The other representative of the cross field is simply rotated by 90 degrees
     Eigen::MatrixXd B1, B2, B3;
@@ -193,6 +300,7 @@ bool Parameterizer::miq(size_t *singularityCount, bool calculateSingularityOnly)
 
     // Global seamless parametrization
     {
+        Tracer::ScopedEvent combEvent("comb_cross_field");
         Eigen::MatrixXd BIS1, BIS2;
         igl::compute_frame_field_bisectors(V_deformed, *m_F, X1_deformed, X2_deformed, BIS1, BIS2);
 
@@ -205,6 +313,8 @@ bool Parameterizer::miq(size_t *singularityCount, bool calculateSingularityOnly)
         Eigen::Matrix<int, Eigen::Dynamic, 1> isSingularity, singularityIndex;
         igl::find_cross_field_singularities(V_deformed, *m_F, Handle_MMatch, isSingularity, singularityIndex);
         
+        combEvent.finish();
+        
         *singularityCount = 0;
         for (int i = 0; i < isSingularity.rows(); ++i) {
             if (isSingularity(i))
@@ -213,11 +323,13 @@ bool Parameterizer::miq(size_t *singularityCount, bool calculateSingularityOnly)
         if (calculateSingularityOnly)
             return true;
 
+        Tracer::ScopedEvent cutEvent("cut_mesh_from_singularities");
         Eigen::Matrix<int, Eigen::Dynamic, 3> Handle_Seams;
         igl::cut_mesh_from_singularities(V_deformed, *m_F, Handle_MMatch, Handle_Seams);
 
         Eigen::MatrixXd PD1_combed, PD2_combed;
         igl::comb_frame_field(V_deformed, *m_F, X1_deformed, X2_deformed, BIS1_combed, BIS2_combed, PD1_combed, PD2_combed);
+        cutEvent.finish();
         
         double stiffness = 5.0;
         bool directRound = false;
@@ -226,7 +338,12 @@ bool Parameterizer::miq(size_t *singularityCount, bool calculateSingularityOnly)
         bool doRound = true;
         bool singularityRound = true;
         const std::vector<int> roundVertices = std::vector<int>();
-        const std::vector<std::vector<int>> hardFeatures = std::vector<std::vector<int>>();
+        // A hard feature is a face and the corner its edge starts at, the edge is put on an integer isoline
+        std::vector<std::vector<int>> hardFeatures;
+        hardFeatures.reserve(m_seamEdges.size());
+        for (const auto &it: m_seamEdges)
+            hardFeatures.push_back({(int)it.face, (int)it.corner});
+        Tracer::ScopedEvent solveEvent("igl::copyleft::comiso::miq");
         igl::copyleft::comiso::miq(V_deformed,
             *m_F,
             PD1_combed,
@@ -252,21 +369,22 @@ bool Parameterizer::miq(size_t *singularityCount, bool calculateSingularityOnly)
         return false;
     }
     
-    size_t faceNum = 0;
-    for (HalfEdge::Face *face = m_mesh->firstFace(); nullptr != face; face = face->_next) {
-        HalfEdge::HalfEdge *h0 = face->anyHalfEdge;
-        HalfEdge::HalfEdge *h1 = h0->nextHalfEdge;
-        HalfEdge::HalfEdge *h2 = h1->nextHalfEdge;
-        const auto &triangleVertexIndices = FUV.row(faceNum++);
+    const auto &faces = m_mesh->faces();
+    auto &halfEdges = m_mesh->halfEdges();
+    for (size_t faceNum = 0; faceNum < faces.size(); ++faceNum) {
+        HalfEdge::HalfEdge &h0 = halfEdges[faces[faceNum].anyHalfEdge];
+        HalfEdge::HalfEdge &h1 = halfEdges[h0.nextHalfEdge];
+        HalfEdge::HalfEdge &h2 = halfEdges[h1.nextHalfEdge];
+        const auto &triangleVertexIndices = FUV.row(faceNum);
         const auto &v0 = UV.row(triangleVertexIndices[0]);
         const auto &v1 = UV.row(triangleVertexIndices[1]);
         const auto &v2 = UV.row(triangleVertexIndices[2]);
-        h0->startVertexUv[0] = v0[0];
-        h0->startVertexUv[1] = v0[1];
-        h1->startVertexUv[0] = v1[0];
-        h1->startVertexUv[1] = v1[1];
-        h2->startVertexUv[0] = v2[0];
-        h2->startVertexUv[1] = v2[1];
+        h0.startVertexUv[0] = v0[0];
+        h0.startVertexUv[1] = v0[1];
+        h1.startVertexUv[0] = v1[0];
+        h1.startVertexUv[1] = v1[1];
+        h2.startVertexUv[0] = v2[0];
+        h2.startVertexUv[1] = v2[1];
     }
     
     return true;
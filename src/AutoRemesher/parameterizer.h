@@ -22,6 +22,7 @@
 #ifndef AUTO_REMESHER_PARAMETRIZATION_H
 #define AUTO_REMESHER_PARAMETRIZATION_H
 #include <AutoRemesher/HalfEdge>
+#include <AutoRemesher/MirrorSymmetry>
 #include <igl/avg_edge_length.h>
 #include <igl/barycenter.h>
 #include <igl/comb_cross_field.h>
@@ -52,6 +53,9 @@ public:
     struct Parameters
     {
         double gradientSize;
+        // The plane a mirrored half was cut on. Its boundary edges in the plane get the cross field along them
+        // and are put on integer isolines, so the extracted quads end on the cut and weld with the mirror image
+        const MirrorSymmetry *symmetry = nullptr;
     };
     
     Parameterizer(HalfEdge::Mesh *mesh, const Parameters &parameters);
@@ -59,6 +63,26 @@ public:
     void prepareConstraints(double limitRelativeHeight);
     bool miq(size_t *singularityCount, bool calculateSingularityOnly);
 private:
+    // A face takes the principal directions of its first corner at or below the limit relative height, an
+    // event is the height where that corner changes, from previousCorner to corner, -1 for none
+    struct ConstraintEvent
+    {
+        double relativeHeight;
+        uint32_t face;
+        int8_t corner;
+        int8_t previousCorner;
+    };
+    
+    // A boundary edge of a face on the cut, from the corner to the next one, with the frame it constrains
+    // the face to: along the edge and across it in the face
+    struct SeamEdge
+    {
+        uint32_t face;
+        int8_t corner;
+        Vector3 direction;
+        Vector3 across;
+    };
+
     Eigen::MatrixXd *m_V = nullptr;
     Eigen::MatrixXi *m_F = nullptr;
     Eigen::MatrixXd *m_PD1 = nullptr;
@@ -68,6 +92,16 @@ private:
     Eigen::MatrixXd *m_bc1 = nullptr;
     Eigen::MatrixXd *m_bc2 = nullptr;
     Parameters m_parameters;
+    std::vector<double> m_sortedRelativeHeights;
+    std::vector<ConstraintEvent> m_constraintEvents;
+    std::vector<int8_t> m_constraintCorners;
+    size_t m_appliedConstraintEventCount = 0;
+    size_t m_constraintCount = 0;
+    double m_preparedLimitRelativeHeight = 0.0;
+    std::vector<SeamEdge> m_seamEdges;
+    
+    void prepareConstraintEvents();
+    void collectSeamEdges(const MirrorSymmetry &symmetry);
 };
     
 }
@@ -28,15 +28,19 @@
 #include <AutoRemesher/QuadRemesher>
 #include <AutoRemesher/HalfEdge>
 #include <AutoRemesher/Radians>
+#include <AutoRemesher/Tracer>
 
 namespace AutoRemesher
 {
 
 bool QuadRemesher::remesh()
 {
+    Tracer::ScopedEvent remeshEvent("QuadRemesher::remesh");
     qex_TriMesh triMesh = {0};
     qex_QuadMesh quadMesh = {0};
     
+    // Compacted, the vertex and face indices are the ones handed to QEx
+    m_mesh->compact();
     triMesh.vertex_count = m_mesh->vertexCount();
     triMesh.tri_count = m_mesh->faceCount();
     
@@ -44,54 +48,45 @@ bool QuadRemesher::remesh()
     triMesh.tris = (qex_Tri*)malloc(sizeof(qex_Tri) * triMesh.tri_count);
     triMesh.uvTris = (qex_UVTri*)malloc(sizeof(qex_UVTri) * triMesh.tri_count);
     
-    size_t vertexNum = 0;
-    for (HalfEdge::Vertex *vertex = m_mesh->firstVertex(); nullptr != vertex; vertex = vertex->_next) {
-        vertex->outputIndex = vertexNum;
-        triMesh.vertices[vertexNum++] = qex_Point3 {{
-            (double)vertex->position.x(), 
-            (double)vertex->position.y(), 
-            (double)vertex->position.z()
+    const auto &vertices = m_mesh->vertices();
+    for (size_t vertexNum = 0; vertexNum < vertices.size(); ++vertexNum) {
+        const auto &position = vertices[vertexNum].position;
+        triMesh.vertices[vertexNum] = qex_Point3 {{
+            (double)position.x(), 
+            (double)position.y(), 
+            (double)position.z()
         }};
     }
     
-    std::vector<HalfEdge::HalfEdge *> triangleHalfEdges;
-    triangleHalfEdges.reserve(triMesh.tri_count * 3);
-    size_t faceNum = 0;
-    for (HalfEdge::Face *face = m_mesh->firstFace(); nullptr != face; face = face->_next) {
-        HalfEdge::HalfEdge *h0 = face->anyHalfEdge;
-        HalfEdge::HalfEdge *h1 = h0->nextHalfEdge;
-        HalfEdge::HalfEdge *h2 = h1->nextHalfEdge;
+    const auto &faces = m_mesh->faces();
+    const auto &halfEdges = m_mesh->halfEdges();
+    for (size_t faceNum = 0; faceNum < faces.size(); ++faceNum) {
+        const HalfEdge::HalfEdge &h0 = halfEdges[faces[faceNum].anyHalfEdge];
+        const HalfEdge::HalfEdge &h1 = halfEdges[h0.nextHalfEdge];
+        const HalfEdge::HalfEdge &h2 = halfEdges[h1.nextHalfEdge];
         triMesh.tris[faceNum] = qex_Tri {{
-            (qex_Index)h0->startVertex->outputIndex, 
-            (qex_Index)h1->startVertex->outputIndex, 
-            (qex_Index)h2->startVertex->outputIndex
+            (qex_Index)h0.startVertex, 
+            (qex_Index)h1.startVertex, 
+            (qex_Index)h2.startVertex
         }};
-        triangleHalfEdges.push_back(h0);
-        triangleHalfEdges.push_back(h1);
-        triangleHalfEdges.push_back(h2);
-        ++faceNum;
-    }
-    
-    faceNum = 0;
-    for (size_t i = 0; i < triangleHalfEdges.size(); ) {
-        auto &h0 = triangleHalfEdges[i++];
-        auto &h1 = triangleHalfEdges[i++];
-        auto &h2 = triangleHalfEdges[i++];
-        triMesh.uvTris[faceNum++] = qex_UVTri {{
-            qex_Point2 {{h0->startVertexUv[0], h0->startVertexUv[1]}}, 
-            qex_Point2 {{h1->startVertexUv[0], h1->startVertexUv[1]}}, 
-            qex_Point2 {{h2->startVertexUv[0], h2->startVertexUv[1]}}
+        triMesh.uvTris[faceNum] = qex_UVTri {{
+            qex_Point2 {{h0.startVertexUv[0], h0.startVertexUv[1]}}, 
+            qex_Point2 {{h1.startVertexUv[0], h1.startVertexUv[1]}}, 
+            qex_Point2 {{h2.startVertexUv[0], h2.startVertexUv[1]}}
         }};
     }
 
-    qex_extractQuadMesh(&triMesh, nullptr, &quadMesh);
+    {
+        Tracer::ScopedEvent event("qex_extractQuadMesh");
+        qex_extractQuadMesh(&triMesh, nullptr, &quadMesh);
+    }
     
     m_remeshedVertices.resize(quadMesh.vertex_count);
     for (unsigned int i = 0; i < quadMesh.vertex_count; ++i) {
         const auto &src = quadMesh.vertices[i];
         m_remeshedVertices[i] = Vector3 {(double)src.x[0], (double)src.x[1], (double)src.x[2]};
     }
-    m_remeshedQuads.reserve(quadMesh.quad_count);
+    m_remeshedQuadIndices.reserve(quadMesh.quad_count * 4);
     for (unsigned int i = 0; i < quadMesh.quad_count; ++i) {
         const auto &src = quadMesh.quads[i];
         if (0 == src.indices[0] ||
@@ -106,7 +101,8 @@ bool QuadRemesher::remesh()
         indices.insert(src.indices[3]);
         if (4 != indices.size())
             continue;
-        m_remeshedQuads.push_back(std::vector<size_t> {src.indices[0], src.indices[1], src.indices[2], src.indices[3]});
+        for (size_t j = 0; j < 4; ++j)
+            m_remeshedQuadIndices.push_back((uint32_t)src.indices[j]);
     }
     
     fixHoles();
@@ -166,22 +162,21 @@ void QuadRemesher::createCoonsPatchFrom(const std::vector<size_t> &c0,
     }
     for (int s = 1; s < (int)c0.size(); ++s) {
         for (int t = 1; t < (int)d0.size(); ++t) {
-            std::vector<size_t> face = {
-                grid[s - 1][t - 1],
-                grid[s - 1][t],
-                grid[s][t],
-                grid[s][t - 1]
-            };
-            m_remeshedQuads.push_back(face);
+            m_remeshedQuadIndices.push_back((uint32_t)grid[s - 1][t - 1]);
+            m_remeshedQuadIndices.push_back((uint32_t)grid[s - 1][t]);
+            m_remeshedQuadIndices.push_back((uint32_t)grid[s][t]);
+            m_remeshedQuadIndices.push_back((uint32_t)grid[s][t - 1]);
         }
     }
 }
 
 void QuadRemesher::fixHoles()
 {
-    Eigen::MatrixXi F(m_remeshedQuads.size() * 2, 3);
-    for (size_t i = 0, j = 0; i < m_remeshedQuads.size(); ++i) {
-        const auto &quad = m_remeshedQuads[i];
+    Tracer::ScopedEvent event("QuadRemesher::fixHoles");
+    size_t quadCount = m_remeshedQuadIndices.size() / 4;
+    Eigen::MatrixXi F(quadCount * 2, 3);
+    for (size_t i = 0, j = 0; i < quadCount; ++i) {
+        const uint32_t *quad = &m_remeshedQuadIndices[i * 4];
         F.row(j++) << quad[0], quad[1], quad[2];
         F.row(j++) << quad[2], quad[3], quad[0];
     }
@@ -247,9 +242,8 @@ void QuadRemesher::fixHoles()
         Vector3::project(ringPoints, &ringPointsIn2d, projectNormal, projectAxis, origin);
         
         if (4 == loop.size()) {
-            m_remeshedQuads.push_back(std::vector<size_t> {
-                (size_t)loop[0], (size_t)loop[1], (size_t)loop[2], (size_t)loop[3]
-            });
+            for (size_t i = 0; i < 4; ++i)
+                m_remeshedQuadIndices.push_back((uint32_t)loop[i]);
         } else if (loop.size() > 4 && loop.size() % 2 == 0) {
             size_t cornerIndex = findCorner(ringPointsIn2d);
             size_t nextCornerIndex = cornerIndex;
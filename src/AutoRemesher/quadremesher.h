@@ -23,6 +23,7 @@
 #define AUTO_REMESHER_QUAD_REMESHER_H
 #include <vector>
 #include <cstddef>
+#include <cstdint>
 #include <map>
 #include <AutoRemesher/Vector3>
 #include <AutoRemesher/HalfEdge>
@@ -43,16 +44,17 @@ public:
         return m_remeshedVertices;
     }
     
-    const std::vector<std::vector<size_t>> &remeshedQuads()
+    // Four indices per quad
+    const std::vector<uint32_t> &remeshedQuadIndices()
     {
-        return m_remeshedQuads;
+        return m_remeshedQuadIndices;
     }
     
     bool remesh();
 private:
     HalfEdge::Mesh *m_mesh = nullptr;
     std::vector<Vector3> m_remeshedVertices;
-    std::vector<std::vector<size_t>> m_remeshedQuads;
+    std::vector<uint32_t> m_remeshedQuadIndices;
     
     void fixHoles();
     void createCoonsPatchFrom(const std::vector<size_t> &c0,
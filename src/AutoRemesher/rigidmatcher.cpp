@@ -0,0 +1,248 @@
+/*
+ *  Copyright (c) 2020 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <unordered_map>
+#include <array>
+#include <AutoRemesher/RigidMatcher>
+
+namespace AutoRemesher
+{
+
+static Eigen::Vector3d toEigen(const Vector3 &v)
+{
+    return Eigen::Vector3d(v.x(), v.y(), v.z());
+}
+
+static Eigen::Vector3d centroid(ArrayView<Vector3> vertices)
+{
+    Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+    for (const auto &it: vertices)
+        sum += toEigen(it);
+    return vertices.empty() ? sum : Eigen::Vector3d(sum / (double)vertices.size());
+}
+
+static Eigen::Matrix3d covariance(ArrayView<Vector3> vertices, const Eigen::Vector3d &center)
+{
+    Eigen::Matrix3d result = Eigen::Matrix3d::Zero();
+    for (const auto &it: vertices) {
+        Eigen::Vector3d offset = toEigen(it) - center;
+        result += offset * offset.transpose();
+    }
+    return vertices.empty() ? result : Eigen::Matrix3d(result / (double)vertices.size());
+}
+
+// Kabsch, the rotation and translation taking the source points closest to the paired target points
+static RigidMatcher::Transform fitTransform(const std::vector<Eigen::Vector3d> &sourcePoints, 
+    const std::vector<Eigen::Vector3d> &targetPoints)
+{
+    Eigen::Vector3d sourceCenter = Eigen::Vector3d::Zero();
+    Eigen::Vector3d targetCenter = Eigen::Vector3d::Zero();
+    for (size_t i = 0; i < sourcePoints.size(); ++i) {
+        sourceCenter += sourcePoints[i];
+        targetCenter += targetPoints[i];
+    }
+    sourceCenter /= (double)sourcePoints.size();
+    targetCenter /= (double)targetPoints.size();
+    Eigen::Matrix3d crossCovariance = Eigen::Matrix3d::Zero();
+    for (size_t i = 0; i < sourcePoints.size(); ++i)
+        crossCovariance += (sourcePoints[i] - sourceCenter) * (targetPoints[i] - targetCenter).transpose();
+    Eigen::JacobiSVD<Eigen::Matrix3d> svd(crossCovariance, Eigen::ComputeFullU | Eigen::ComputeFullV);
+    Eigen::Matrix3d correction = Eigen::Matrix3d::Identity();
+    if ((svd.matrixV() * svd.matrixU().transpose()).determinant() < 0.0)
+        correction(2, 2) = -1.0;
+    RigidMatcher::Transform transform;
+    transform.rotation = svd.matrixV() * correction * svd.matrixU().transpose();
+    transform.translation = targetCenter - transform.rotation * sourceCenter;
+    return transform;
+}
+
+// Triangles as sorted lists of rotated index triples, each starting at its smallest index, which compares
+// the faces whatever their order and starting corner while the winding still counts
+static std::vector<std::array<uint32_t, 3>> canonicalTriangles(ArrayView<uint32_t> triangleIndices,
+    const std::vector<uint32_t> *vertexMap)
+{
+    std::vector<std::array<uint32_t, 3>> triangles(triangleIndices.size() / 3);
+    for (size_t i = 0; i < triangles.size(); ++i) {
+        auto &triangle = triangles[i];
+        for (size_t j = 0; j < 3; ++j) {
+            uint32_t index = triangleIndices[i * 3 + j];
+            triangle[j] = nullptr == vertexMap ? index : (*vertexMap)[index];
+        }
+        std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+std::vector<int64_t> RigidMatcher::signature(ArrayView<Vector3> vertices, 
+    ArrayView<uint32_t> triangleIndices)
+{
+    double area = 0.0;
+    for (size_t i = 0; i + 2 < triangleIndices.size(); i += 3) {
+        area += Vector3::area(vertices[triangleIndices[i]], 
+            vertices[triangleIndices[i + 1]], 
+            vertices[triangleIndices[i + 2]]);
+    }
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(covariance(vertices, centroid(vertices)));
+    const Eigen::Vector3d &variances = solver.eigenvalues();
+    
+    // Log scale steps of 0.1%, values at zero, like the thickness of a flat part, share one bucket
+    double largest = std::max(std::sqrt(std::max(variances[2], 0.0)), std::sqrt(area));
+    auto quantize = [&](double length) {
+        if (length <= largest * 1e-6)
+            return std::numeric_limits<int64_t>::min();
+        return (int64_t)std::llround(std::log(length) * 1000.0);
+    };
+    return {
+        (int64_t)vertices.size(),
+        (int64_t)(triangleIndices.size() / 3),
+        quantize(std::sqrt(area)),
+        quantize(std::sqrt(std::max(variances[0], 0.0))),
+        quantize(std::sqrt(std::max(variances[1], 0.0))),
+        quantize(std::sqrt(std::max(variances[2], 0.0)))
+    };
+}
+
+double RigidMatcher::radius(ArrayView<Vector3> vertices)
+{
+    Eigen::Vector3d center = centroid(vertices);
+    double maxDistance2 = 0.0;
+    for (const auto &it: vertices)
+        maxDistance2 = std::max(maxDistance2, (toEigen(it) - center).squaredNorm());
+    return std::sqrt(maxDistance2);
+}
+
+bool RigidMatcher::match(ArrayView<Vector3> source, ArrayView<uint32_t> sourceTriangleIndices,
+    ArrayView<Vector3> target, ArrayView<uint32_t> targetTriangleIndices,
+    double tolerance, Transform *transform)
+{
+    if (source.size() != target.size() || 
+            sourceTriangleIndices.size() != targetTriangleIndices.size() ||
+            source.empty())
+        return false;
+    
+    std::vector<Eigen::Vector3d> sourcePoints(source.size());
+    std::vector<Eigen::Vector3d> targetPoints(target.size());
+    for (size_t i = 0; i < source.size(); ++i) {
+        sourcePoints[i] = toEigen(source[i]);
+        targetPoints[i] = toEigen(target[i]);
+    }
+    
+    // Instanced copies keep the vertex and face order, which pairs the vertices up already
+    if (std::equal(sourceTriangleIndices.begin(), sourceTriangleIndices.end(), targetTriangleIndices.begin())) {
+        *transform = fitTransform(sourcePoints, targetPoints);
+        for (size_t i = 0; i < source.size(); ++i) {
+            if ((transform->rotation * sourcePoints[i] + transform->translation - targetPoints[i]).norm() > tolerance)
+                return false;
+        }
+        return true;
+    }
+    
+    // Otherwise the principal axes give the rotation up to the axis signs. Nearly equal extents leave the
+    // axes undefined, such islands are only matched by vertex order
+    Eigen::Vector3d sourceCenter = centroid(source);
+    Eigen::Vector3d targetCenter = centroid(target);
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> sourceSolver(covariance(source, sourceCenter));
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> targetSolver(covariance(target, targetCenter));
+    const Eigen::Vector3d &variances = sourceSolver.eigenvalues();
+    if (variances[1] - variances[0] < variances[2] * 1e-2 || variances[2] - variances[1] < variances[2] * 1e-2)
+        return false;
+    
+    // Every target vertex looks for a source vertex in the cells around it, cells are as wide as the tolerance
+    auto cellKey = [&](const Eigen::Vector3d &point) {
+        int64_t x = (int64_t)std::floor(point.x() / tolerance);
+        int64_t y = (int64_t)std::floor(point.y() / tolerance);
+        int64_t z = (int64_t)std::floor(point.z() / tolerance);
+        return (uint64_t)((x * 73856093) ^ (y * 19349663) ^ (z * 83492791));
+    };
+    std::unordered_multimap<uint64_t, size_t> sourceCells;
+    std::vector<std::array<uint32_t, 3>> targetTriangles;
+    
+    const double signs[4][3] = {{1, 1, 1}, {-1, -1, 1}, {-1, 1, -1}, {1, -1, -1}};
+    for (const auto &sign: signs) {
+        Eigen::Matrix3d sourceAxes = sourceSolver.eigenvectors();
+        Eigen::Matrix3d targetAxes = targetSolver.eigenvectors();
+        for (int axis = 0; axis < 3; ++axis)
+            targetAxes.col(axis) *= sign[axis];
+        if (sourceAxes.determinant() * targetAxes.determinant() < 0.0)
+            targetAxes.col(0) *= -1.0;
+        Transform candidate;
+        candidate.rotation = targetAxes * sourceAxes.transpose();
+        candidate.translation = targetCenter - candidate.rotation * sourceCenter;
+        
+        // Pair each target vertex with the nearest moved source vertex, then refine on those pairs
+        sourceCells.clear();
+        std::vector<Eigen::Vector3d> movedSource(source.size());
+        for (size_t i = 0; i < source.size(); ++i) {
+            movedSource[i] = candidate.rotation * sourcePoints[i] + candidate.translation;
+            sourceCells.insert({cellKey(movedSource[i]), i});
+        }
+        // One to one, two target vertices never share a source vertex
+        const uint32_t unpairedVertex = std::numeric_limits<uint32_t>::max();
+        std::vector<uint32_t> sourceToTarget(source.size(), unpairedVertex);
+        std::vector<Eigen::Vector3d> pairedSource;
+        pairedSource.reserve(target.size());
+        for (size_t targetIndex = 0; targetIndex < targetPoints.size(); ++targetIndex) {
+            const auto &point = targetPoints[targetIndex];
+            double bestDistance = tolerance;
+            size_t bestIndex = std::numeric_limits<size_t>::max();
+            for (int dx = -1; dx <= 1; ++dx) {
+                for (int dy = -1; dy <= 1; ++dy) {
+                    for (int dz = -1; dz <= 1; ++dz) {
+                        auto range = sourceCells.equal_range(cellKey(point + Eigen::Vector3d(dx, dy, dz) * tolerance));
+                        for (auto it = range.first; it != range.second; ++it) {
+                            double distance = (movedSource[it->second] - point).norm();
+                            if (distance <= bestDistance) {
+                                bestDistance = distance;
+                                bestIndex = it->second;
+                            }
+                        }
+                    }
+                }
+            }
+            if (std::numeric_limits<size_t>::max() == bestIndex || unpairedVertex != sourceToTarget[bestIndex])
+                break;
+            sourceToTarget[bestIndex] = (uint32_t)targetIndex;
+            pairedSource.push_back(sourcePoints[bestIndex]);
+        }
+        if (pairedSource.size() != target.size())
+            continue;
+        
+        // The same points may be triangulated another way, the quads of the source would not fit then
+        if (targetTriangles.empty())
+            targetTriangles = canonicalTriangles(targetTriangleIndices, nullptr);
+        if (canonicalTriangles(sourceTriangleIndices, &sourceToTarget) != targetTriangles)
+            continue;
+        
+        *transform = fitTransform(pairedSource, targetPoints);
+        bool matched = true;
+        for (size_t i = 0; matched && i < target.size(); ++i)
+            matched = (transform->rotation * pairedSource[i] + transform->translation - targetPoints[i]).norm() <= tolerance;
+        if (matched)
+            return true;
+    }
+    return false;
+}
+
+}
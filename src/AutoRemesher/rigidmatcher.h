@@ -0,0 +1,69 @@
+/*
+ *  Copyright (c) 2020 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+#ifndef AUTO_REMESHER_RIGID_MATCHER_H
+#define AUTO_REMESHER_RIGID_MATCHER_H
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <Eigen/Dense>
+#include <AutoRemesher/Vector3>
+#include <AutoRemesher/ArrayView>
+
+namespace AutoRemesher
+{
+
+// Tells whether two islands are the same shape up to a rotation and a translation, mirrored copies don't count
+class RigidMatcher
+{
+public:
+    struct Transform
+    {
+        Eigen::Matrix3d rotation = Eigen::Matrix3d::Identity();
+        Eigen::Vector3d translation = Eigen::Vector3d::Zero();
+        
+        Vector3 apply(const Vector3 &v) const
+        {
+            Eigen::Vector3d result = rotation * Eigen::Vector3d(v.x(), v.y(), v.z()) + translation;
+            return Vector3(result.x(), result.y(), result.z());
+        }
+    };
+    
+    // Equal for congruent islands except near a quantization step: vertex and triangle counts, area and
+    // the principal extents. Islands with different signatures are never compared
+    static std::vector<int64_t> signature(ArrayView<Vector3> vertices, 
+        ArrayView<uint32_t> triangleIndices);
+    
+    // The tolerance is a distance, every target vertex has to land this close to its own source vertex, and
+    // the source triangles carried over by that pairing have to be the target triangles, so a different
+    // triangulation of the same points doesn't match. Copies with the same vertex order are aligned by
+    // index, others by their principal axes
+    static bool match(ArrayView<Vector3> source, ArrayView<uint32_t> sourceTriangleIndices,
+        ArrayView<Vector3> target, ArrayView<uint32_t> targetTriangleIndices,
+        double tolerance, Transform *transform);
+    
+    // Largest distance of a vertex from the centroid, the same for every rotation
+    static double radius(ArrayView<Vector3> vertices);
+};
+
+}
+
+#endif
@@ -0,0 +1,166 @@
+/*
+ *  Copyright (c) 2020 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+#include <cstdio>
+#include <vector>
+#include <mutex>
+#include <map>
+#include <limits>
+#include <tbb/tick_count.h>
+#include <AutoRemesher/Tracer>
+
+namespace AutoRemesher
+{
+
+const size_t Tracer::m_noIsland = std::numeric_limits<size_t>::max();
+std::atomic<bool> Tracer::m_enabled{false};
+
+namespace
+{
+
+std::mutex g_traceMutex;
+std::vector<Tracer::Event> g_traceEvents;
+// Event times are taken without the lock while start() may run again, so the start is kept as an atomic
+// offset from a fixed epoch rather than as a tick count written under the lock
+const tbb::tick_count g_traceEpoch = tbb::tick_count::now();
+std::atomic<double> g_traceStartSeconds{0.0};
+std::atomic<int> g_nextThreadNumber{0};
+thread_local int t_threadNumber = -1;
+thread_local size_t t_islandIndex = Tracer::m_noIsland;
+
+double nowMicroseconds()
+{
+    return ((tbb::tick_count::now() - g_traceEpoch).seconds() - g_traceStartSeconds.load()) * 1000000.0;
+}
+
+// Small stable numbers read better in the viewer than native thread ids
+int currentThreadNumber()
+{
+    if (-1 == t_threadNumber)
+        t_threadNumber = g_nextThreadNumber++;
+    return t_threadNumber;
+}
+
+}
+
+Tracer::ScopedEvent::ScopedEvent(const char *name) :
+    m_name(name)
+{
+    if (isEnabled())
+        m_startMicroseconds = nowMicroseconds();
+}
+
+Tracer::ScopedEvent::~ScopedEvent()
+{
+    finish();
+}
+
+void Tracer::ScopedEvent::finish()
+{
+    if (m_startMicroseconds < 0.0)
+        return;
+    Event event;
+    event.name = m_name;
+    event.islandIndex = t_islandIndex;
+    event.threadNumber = currentThreadNumber();
+    event.startMicroseconds = m_startMicroseconds;
+    event.durationMicroseconds = nowMicroseconds() - m_startMicroseconds;
+    m_startMicroseconds = -1.0;
+    if (!isEnabled())
+        return;
+    std::lock_guard<std::mutex> lock(g_traceMutex);
+    g_traceEvents.push_back(event);
+}
+
+Tracer::ScopedIsland::ScopedIsland(size_t islandIndex) :
+    m_previousIslandIndex(t_islandIndex)
+{
+    t_islandIndex = islandIndex;
+}
+
+Tracer::ScopedIsland::~ScopedIsland()
+{
+    t_islandIndex = m_previousIslandIndex;
+}
+
+void Tracer::start()
+{
+    std::lock_guard<std::mutex> lock(g_traceMutex);
+    g_traceEvents.clear();
+    g_traceStartSeconds.store((tbb::tick_count::now() - g_traceEpoch).seconds());
+    m_enabled = true;
+}
+
+void Tracer::stop()
+{
+    m_enabled = false;
+}
+
+bool Tracer::save(const std::string &filename)
+{
+    FILE *fp = fopen(filename.c_str(), "wb");
+    if (nullptr == fp)
+        return false;
+    
+    std::lock_guard<std::mutex> lock(g_traceMutex);
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    int threadCount = g_nextThreadNumber;
+    for (int i = 0; i < threadCount; ++i) {
+        fprintf(fp, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"worker %d\"}},\n", 
+            i, i);
+    }
+    for (size_t i = 0; i < g_traceEvents.size(); ++i) {
+        const auto &event = g_traceEvents[i];
+        fprintf(fp, "{\"name\":\"%s\",\"cat\":\"autoremesher\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f", 
+            event.name, event.threadNumber, event.startMicroseconds, event.durationMicroseconds);
+        if (m_noIsland != event.islandIndex)
+            fprintf(fp, ",\"args\":{\"island\":%zu}", event.islandIndex);
+        fprintf(fp, "}%s\n", i + 1 < g_traceEvents.size() ? "," : "");
+    }
+    fprintf(fp, "]}\n");
+    return 0 == fclose(fp);
+}
+
+std::vector<Tracer::Event> Tracer::events()
+{
+    std::lock_guard<std::mutex> lock(g_traceMutex);
+    return g_traceEvents;
+}
+
+std::vector<Tracer::EventTotal> Tracer::totals()
+{
+    std::lock_guard<std::mutex> lock(g_traceMutex);
+    std::vector<EventTotal> eventTotals;
+    std::map<std::string, size_t> totalIndices;
+    for (const auto &event: g_traceEvents) {
+        auto insertResult = totalIndices.insert({event.name, eventTotals.size()});
+        if (insertResult.second) {
+            eventTotals.push_back(EventTotal());
+            eventTotals.back().name = event.name;
+        }
+        auto &total = eventTotals[insertResult.first->second];
+        ++total.count;
+        total.seconds += event.durationMicroseconds / 1000000.0;
+    }
+    return eventTotals;
+}
+
+}
@@ -0,0 +1,97 @@
+/*
+ *  Copyright (c) 2020 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+#ifndef AUTO_REMESHER_TRACER_H
+#define AUTO_REMESHER_TRACER_H
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <atomic>
+
+namespace AutoRemesher
+{
+    
+// Process wide timeline of the pipeline stages, saved as a Chrome trace (chrome://tracing or Perfetto).
+// Nothing is recorded until start(), so the scoped events can stay in release builds
+class Tracer
+{
+public:
+    // The name must outlive the trace, string literals are expected
+    class ScopedEvent
+    {
+    public:
+        ScopedEvent(const char *name);
+        ~ScopedEvent();
+        // Ends the event before the scope does, for steps which share variables with the code after them
+        void finish();
+    private:
+        const char *m_name = nullptr;
+        double m_startMicroseconds = -1.0;
+    };
+    
+    // Tags the events of the current thread with an island. The previous island is restored on exit,
+    // a worker waiting on nested tasks may run the tasks of another island in between
+    class ScopedIsland
+    {
+    public:
+        ScopedIsland(size_t islandIndex);
+        ~ScopedIsland();
+    private:
+        size_t m_previousIslandIndex = m_noIsland;
+    };
+    
+    struct Event
+    {
+        const char *name;
+        size_t islandIndex;
+        int threadNumber;
+        double startMicroseconds;
+        double durationMicroseconds;
+    };
+    
+    struct EventTotal
+    {
+        std::string name;
+        size_t count = 0;
+        double seconds = 0.0;
+    };
+    
+    // Clears the events recorded so far
+    static void start();
+    static void stop();
+    static bool isEnabled()
+    {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+    static bool save(const std::string &filename);
+    // The recorded events in the order they finished, a nested event finishes before its parent
+    static std::vector<Event> events();
+    // The recorded events summed up by name, in the order each name first finished
+    static std::vector<EventTotal> totals();
+    
+    static const size_t m_noIsland;
+private:
+    static std::atomic<bool> m_enabled;
+};
+    
+}
+
+#endif
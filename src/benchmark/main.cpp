@@ -0,0 +1,630 @@
+/*
+ *  Copyright (c) 2020 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstring>
+#include <map>
+#include <algorithm>
+#include <random>
+#include <limits>
+#include <tbb/task_scheduler_init.h>
+#include <tbb/task_arena.h>
+#include <tbb/tick_count.h>
+#include <AutoRemesher/AutoRemesher>
+#include <AutoRemesher/MemoryUsage>
+#include <AutoRemesher/MirrorSymmetry>
+#include <AutoRemesher/Tracer>
+#include "syntheticmesh.h"
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "../tiny_obj_loader.h"
+
+struct SplitOptions
+{
+    size_t patchCount = 2000;
+    size_t patchSize = 35;
+    size_t repeatCount = 3;
+};
+
+struct StagesOptions
+{
+    std::vector<std::string> cases = {"sphere", "torus", "genus", "noisy", "assembly"};
+    size_t triangleCount = 20000;
+    size_t holeCount = 8;
+    size_t partCount = 50;
+    size_t repeatCount = 1;
+    size_t threadCount = (size_t)tbb::task_scheduler_init::default_num_threads();
+    std::string jsonFilename;
+    std::string objDirectory;
+    std::string symmetry = "off";
+};
+
+struct ScalingOptions
+{
+    std::string caseName = "assembly";
+    std::string inputFilename;
+    size_t maxThreadCount = (size_t)tbb::task_scheduler_init::default_num_threads();
+    size_t repeatCount = 1;
+    std::string jsonFilename;
+};
+
+static void printUsage(const char *program)
+{
+    std::cerr << "Usage: " << program << " split|stages|scaling [options]" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "split: time island splitting, the map based search against the union find one" << std::endl;
+    std::cerr << "  --patches <n>       Disconnected grid patches in the generated mesh (default: 2000)" << std::endl;
+    std::cerr << "  --patch-size <n>    Quads along each side of a patch (default: 35)" << std::endl;
+    std::cerr << "  --repeat <n>        Runs of each version, the fastest is reported (default: 3)" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "stages: remesh generated meshes end to end and time every stage" << std::endl;
+    std::cerr << "  --cases <a,b,...>   Any of sphere, torus, genus, noisy, assembly (default: all)" << std::endl;
+    std::cerr << "  --triangles <n>     Triangles in each generated mesh (default: 20000)" << std::endl;
+    std::cerr << "  --holes <n>         Genus of the genus case (default: 8)" << std::endl;
+    std::cerr << "  --parts <n>         Disconnected parts in the assembly case (default: 50)" << std::endl;
+    std::cerr << "  --repeat <n>        Runs of each case, the fastest is reported (default: 1)" << std::endl;
+    std::cerr << "  --json <file>       Also write the results as JSON, to diff between builds" << std::endl;
+    std::cerr << "  --write-obj <dir>   Also write the generated meshes, to feed them to autoremesher-cli" << std::endl;
+    std::cerr << "  --symmetry <mode>   Remesh in mirror symmetry mode, detect, x, y or z, and check the seams are closed (default: off)" << std::endl;
+    std::cerr << "  --threads <n>       Worker threads, 1 to calibrate the island memory estimate (default: all cores)" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "scaling: remesh one mesh on 1, 2, 4... threads, report speed-up, efficiency and idle time" << std::endl;
+    std::cerr << "  --case <name>       Generated mesh, as in stages, --triangles, --holes and --parts apply (default: assembly)" << std::endl;
+    std::cerr << "  --input <file.obj>  Remesh this file instead of a generated mesh" << std::endl;
+    std::cerr << "  --max-threads <n>   Highest thread count (default: all cores)" << std::endl;
+    std::cerr << "  --repeat <n>        Runs at each thread count, the fastest is reported (default: 1)" << std::endl;
+    std::cerr << "  --json <file>       Also write the results as JSON" << std::endl;
+}
+
+static bool parseSize(const char *value, size_t *size)
+{
+    long long number = std::atoll(value);
+    if (number <= 0)
+        return false;
+    *size = (size_t)number;
+    return true;
+}
+
+// Square grid patches, two triangles per quad, faces shuffled so the islands interleave like in scanned data
+static void makeGridPatches(size_t patchCount, size_t patchSize, std::vector<std::vector<size_t>> *triangles)
+{
+    size_t vertexStartIndex = 0;
+    size_t rowSize = patchSize + 1;
+    for (size_t patch = 0; patch < patchCount; ++patch) {
+        for (size_t i = 0; i < patchSize; ++i) {
+            for (size_t j = 0; j < patchSize; ++j) {
+                size_t a = vertexStartIndex + i * rowSize + j;
+                size_t b = a + 1;
+                size_t c = a + rowSize;
+                size_t d = c + 1;
+                triangles->push_back({a, b, d});
+                triangles->push_back({a, d, c});
+            }
+        }
+        vertexStartIndex += rowSize * rowSize;
+    }
+    std::mt19937 random(0);
+    std::shuffle(triangles->begin(), triangles->end(), random);
+}
+
+static int runSplit(const SplitOptions &options)
+{
+    std::vector<std::vector<size_t>> triangles;
+    makeGridPatches(options.patchCount, options.patchSize, &triangles);
+    printf("triangles:%zu patches:%zu\n", triangles.size(), options.patchCount);
+    std::vector<uint32_t> triangleIndices;
+    triangleIndices.reserve(triangles.size() * 3);
+    for (const auto &face: triangles) {
+        for (const auto &index: face)
+            triangleIndices.push_back((uint32_t)index);
+    }
+    
+    double edgeMapSeconds = std::numeric_limits<double>::max();
+    std::vector<std::vector<std::vector<size_t>>> islands;
+    for (size_t i = 0; i < options.repeatCount; ++i) {
+        islands.clear();
+        tbb::tick_count startTime = tbb::tick_count::now();
+        AutoRemesher::AutoRemesher::splitToIslandsByEdgeMap(triangles, islands);
+        edgeMapSeconds = std::min(edgeMapSeconds, (tbb::tick_count::now() - startTime).seconds());
+    }
+    
+    double unionFindSeconds = std::numeric_limits<double>::max();
+    std::vector<size_t> islandFaces;
+    std::vector<size_t> islandOffsets;
+    for (size_t i = 0; i < options.repeatCount; ++i) {
+        tbb::tick_count startTime = tbb::tick_count::now();
+        AutoRemesher::AutoRemesher::splitToIslands(triangleIndices, &islandFaces, &islandOffsets);
+        unionFindSeconds = std::min(unionFindSeconds, (tbb::tick_count::now() - startTime).seconds());
+    }
+    
+    // Both number the islands by their lowest face, so the same faces must land in the same island
+    bool same = islands.size() + 1 == islandOffsets.size();
+    for (size_t i = 0; same && i < islands.size(); ++i) {
+        std::vector<std::vector<size_t>> unionFindIsland;
+        for (size_t k = islandOffsets[i]; k < islandOffsets[i + 1]; ++k)
+            unionFindIsland.push_back(triangles[islandFaces[k]]);
+        std::vector<std::vector<size_t>> edgeMapIsland = islands[i];
+        std::sort(unionFindIsland.begin(), unionFindIsland.end());
+        std::sort(edgeMapIsland.begin(), edgeMapIsland.end());
+        same = unionFindIsland == edgeMapIsland;
+    }
+    
+    printf("edge map:   islands:%zu seconds:%.4f\n", islands.size(), edgeMapSeconds);
+    printf("union find: islands:%zu seconds:%.4f\n", islandOffsets.size() - 1, unionFindSeconds);
+    printf("speed-up:%.2fx results:%s\n", edgeMapSeconds / unionFindSeconds, same ? "identical" : "DIFFERENT");
+    return same ? 0 : 1;
+}
+
+struct StageResult
+{
+    std::string name;
+    size_t triangleCount = 0;
+    size_t islandCount = 0;
+    size_t quadCount = 0;
+    double seconds = 0.0;
+    size_t estimatedMemory = 0;
+    size_t residentGrowth = 0;
+    std::vector<AutoRemesher::Tracer::EventTotal> stages;
+};
+
+static bool makeCase(const std::string &name, const StagesOptions &options, SyntheticMesh *mesh)
+{
+    if ("sphere" == name)
+        *mesh = SyntheticMesh::uvSphere(options.triangleCount);
+    else if ("torus" == name)
+        *mesh = SyntheticMesh::torus(options.triangleCount);
+    else if ("genus" == name)
+        *mesh = SyntheticMesh::perforatedPlate(options.holeCount, options.triangleCount);
+    else if ("noisy" == name)
+        *mesh = SyntheticMesh::noisyScan(options.triangleCount, 0.01, 0);
+    else if ("assembly" == name)
+        *mesh = SyntheticMesh::assembly(options.partCount, options.triangleCount, 0);
+    else
+        return false;
+    return true;
+}
+
+static bool parseSymmetry(const std::string &name, AutoRemesher::AutoRemesher::Symmetry *symmetry)
+{
+    if ("off" == name)
+        *symmetry = AutoRemesher::AutoRemesher::Symmetry::Off;
+    else if ("detect" == name)
+        *symmetry = AutoRemesher::AutoRemesher::Symmetry::Detect;
+    else if ("x" == name)
+        *symmetry = AutoRemesher::AutoRemesher::Symmetry::X;
+    else if ("y" == name)
+        *symmetry = AutoRemesher::AutoRemesher::Symmetry::Y;
+    else if ("z" == name)
+        *symmetry = AutoRemesher::AutoRemesher::Symmetry::Z;
+    else
+        return false;
+    return true;
+}
+
+// A mirrored result must have the boundary loops of the input, a crack along a seam adds one or opens
+// a notch into an existing one. With a single island and a fixed axis the plane is known as well,
+// no boundary edge may run along it
+static bool checkSeams(const SyntheticMesh &mesh, AutoRemesher::AutoRemesher &autoRemesher, 
+    AutoRemesher::AutoRemesher::Symmetry symmetry)
+{
+    const auto &vertices = autoRemesher.remeshedVertices();
+    const auto &quadIndices = autoRemesher.remeshedQuadIndices();
+    size_t inputLoopCount = AutoRemesher::MirrorSymmetry::boundaryLoopCount(mesh.triangleIndices, 3);
+    size_t outputLoopCount = AutoRemesher::MirrorSymmetry::boundaryLoopCount(quadIndices, 4);
+    size_t seamEdgeCount = 0;
+    if (AutoRemesher::AutoRemesher::Symmetry::Detect != symmetry && 1 == autoRemesher.islandTimings().size()) {
+        AutoRemesher::Vector3 normal(AutoRemesher::AutoRemesher::Symmetry::X == symmetry ? 1.0 : 0.0,
+            AutoRemesher::AutoRemesher::Symmetry::Y == symmetry ? 1.0 : 0.0,
+            AutoRemesher::AutoRemesher::Symmetry::Z == symmetry ? 1.0 : 0.0);
+        auto plane = AutoRemesher::MirrorSymmetry::throughCentroid(mesh.vertices, normal);
+        double edgeLengthSum = 0.0;
+        for (size_t i = 0; i + 3 < quadIndices.size(); i += 4)
+            edgeLengthSum += (vertices[quadIndices[i + 1]] - vertices[quadIndices[i]]).length();
+        double averageEdgeLength = quadIndices.empty() ? 0.0 : edgeLengthSum * 4.0 / quadIndices.size();
+        seamEdgeCount = plane.seamBoundaryEdgeCount(vertices, quadIndices, averageEdgeLength);
+    }
+    printf("    mirrored islands:%zu boundary loops:%zu (input:%zu) seam boundary edges:%zu seams:%s\n",
+        autoRemesher.mirroredIslandCount(), outputLoopCount, inputLoopCount, seamEdgeCount,
+        outputLoopCount == inputLoopCount && 0 == seamEdgeCount ? "closed" : "CRACKED");
+    return outputLoopCount == inputLoopCount && 0 == seamEdgeCount;
+}
+
+static bool saveStagesJson(const std::string &filename, const std::vector<StageResult> &results)
+{
+    FILE *fp = fopen(filename.c_str(), "wb");
+    if (nullptr == fp)
+        return false;
+    fprintf(fp, "{\n  \"benchmark\": \"stages\",\n  \"cases\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto &result = results[i];
+        fprintf(fp, "    {\"name\": \"%s\", \"triangles\": %zu, \"islands\": %zu, \"quads\": %zu, \"seconds\": %.6f, "
+                "\"estimatedPeakBytes\": %zu, \"residentPeakGrowthBytes\": %zu, \"stages\": [\n",
+            result.name.c_str(), result.triangleCount, result.islandCount, result.quadCount, result.seconds,
+            result.estimatedMemory, result.residentGrowth);
+        for (size_t j = 0; j < result.stages.size(); ++j) {
+            const auto &stage = result.stages[j];
+            fprintf(fp, "      {\"name\": \"%s\", \"count\": %zu, \"seconds\": %.6f}%s\n",
+                stage.name.c_str(), stage.count, stage.seconds, j + 1 < result.stages.size() ? "," : "");
+        }
+        fprintf(fp, "    ]}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+    return 0 == fclose(fp);
+}
+
+// The stage times come from the tracer events, summed over every island and thread,
+// so they add up to more than the end to end time when islands run in parallel
+static int runStages(const StagesOptions &options)
+{
+    AutoRemesher::AutoRemesher::Symmetry symmetry = AutoRemesher::AutoRemesher::Symmetry::Off;
+    if (!parseSymmetry(options.symmetry, &symmetry)) {
+        std::cerr << "Unknown symmetry: " << options.symmetry << std::endl;
+        return 2;
+    }
+    std::vector<StageResult> results;
+    bool succeed = true;
+    for (const auto &name: options.cases) {
+        SyntheticMesh mesh;
+        if (!makeCase(name, options, &mesh)) {
+            std::cerr << "Unknown case: " << name << std::endl;
+            return 2;
+        }
+        if (!options.objDirectory.empty() && !mesh.saveObj(options.objDirectory + "/" + name + ".obj"))
+            std::cerr << "Save " << name << ".obj to " << options.objDirectory << " failed" << std::endl;
+        
+        StageResult best;
+        best.name = name;
+        best.triangleCount = mesh.triangleCount();
+        best.seconds = std::numeric_limits<double>::max();
+        for (size_t i = 0; i < options.repeatCount; ++i) {
+            AutoRemesher::AutoRemesher autoRemesher(mesh.vertices, mesh.triangleIndices);
+            autoRemesher.setSymmetry(symmetry);
+            AutoRemesher::Tracer::start();
+            // The process peak only ever rises, what a remesh adds to it shows once, on the first case
+            // to need that much. Calibrate the estimate one case per run
+            size_t residentBefore = AutoRemesher::MemoryUsage::peakResidentBytes();
+            tbb::tick_count startTime = tbb::tick_count::now();
+            bool remeshSucceed = autoRemesher.remesh();
+            double seconds = (tbb::tick_count::now() - startTime).seconds();
+            AutoRemesher::Tracer::stop();
+            best.estimatedMemory = autoRemesher.peakEstimatedMemory();
+            best.residentGrowth = std::max(best.residentGrowth, 
+                AutoRemesher::MemoryUsage::peakResidentBytes() - residentBefore);
+            if (!remeshSucceed) {
+                std::cerr << "Remesh " << name << " failed" << std::endl;
+                succeed = false;
+                break;
+            }
+            if (AutoRemesher::AutoRemesher::Symmetry::Off != symmetry && !checkSeams(mesh, autoRemesher, symmetry)) {
+                std::cerr << "Remesh " << name << " left a crack along a mirror seam" << std::endl;
+                succeed = false;
+            }
+            // The sphere and the torus are symmetric on every axis, falling back to the whole island
+            // there means the halves never weld
+            if (AutoRemesher::AutoRemesher::Symmetry::Off != symmetry && ("sphere" == name || "torus" == name) &&
+                    0 == autoRemesher.mirroredIslandCount()) {
+                std::cerr << "Remesh " << name << " didn't mirror" << std::endl;
+                succeed = false;
+            }
+            if (seconds < best.seconds) {
+                best.seconds = seconds;
+                best.islandCount = autoRemesher.islandTimings().size();
+                best.quadCount = autoRemesher.remeshedQuadIndices().size() / 4;
+                best.stages = AutoRemesher::Tracer::totals();
+            }
+        }
+        if (best.stages.empty())
+            continue;
+        
+        printf("%s: triangles:%zu islands:%zu quads:%zu seconds:%.3f\n", 
+            best.name.c_str(), best.triangleCount, best.islandCount, best.quadCount, best.seconds);
+        for (const auto &stage: best.stages)
+            printf("    %-40s count:%-6zu seconds:%.3f\n", stage.name.c_str(), stage.count, stage.seconds);
+        printf("    memory: estimated peak:%zu resident peak growth:%zu resident/estimated:%.2f\n",
+            best.estimatedMemory, best.residentGrowth, 
+            0 == best.estimatedMemory ? 0.0 : (double)best.residentGrowth / best.estimatedMemory);
+        results.push_back(best);
+    }
+    
+    if (!options.jsonFilename.empty() && !saveStagesJson(options.jsonFilename, results)) {
+        std::cerr << "Save to " << options.jsonFilename << " failed" << std::endl;
+        return 1;
+    }
+    return succeed ? 0 : 1;
+}
+
+static bool loadObj(const std::string &filename, SyntheticMesh *mesh)
+{
+    tinyobj::attrib_t attributes;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warn, err;
+    if (!tinyobj::LoadObj(&attributes, &shapes, &materials, &warn, &err, filename.c_str()))
+        return false;
+    for (size_t i = 0; i + 2 < attributes.vertices.size(); i += 3) {
+        mesh->vertices.push_back(AutoRemesher::Vector3(attributes.vertices[i], 
+            attributes.vertices[i + 1], 
+            attributes.vertices[i + 2]));
+    }
+    for (const auto &shape: shapes) {
+        for (const auto &index: shape.mesh.indices)
+            mesh->triangleIndices.push_back((uint32_t)index.vertex_index);
+    }
+    return true;
+}
+
+struct PhaseScaling
+{
+    const char *name;
+    double busySeconds = 0.0;
+    double idleSeconds = 0.0;
+};
+
+struct ScalingResult
+{
+    size_t threadCount = 0;
+    double seconds = 0.0;
+    std::vector<PhaseScaling> phases;
+};
+
+// Thread seconds nobody spent on any traced work while a phase was running: over the span from the
+// first start to the last end of the phase, the thread count times the span minus the time each worker
+// was inside an event. A worker blocked inside a parent event, waiting on the candidates of its island,
+// counts as busy
+static std::vector<PhaseScaling> measurePhases(const std::vector<AutoRemesher::Tracer::Event> &events, 
+    size_t threadCount)
+{
+    std::map<int, std::vector<std::pair<double, double>>> threadIntervals;
+    for (const auto &event: events) {
+        threadIntervals[event.threadNumber].push_back({event.startMicroseconds, 
+            event.startMicroseconds + event.durationMicroseconds});
+    }
+    for (auto &it: threadIntervals) {
+        auto &intervals = it.second;
+        std::sort(intervals.begin(), intervals.end());
+        std::vector<std::pair<double, double>> merged;
+        for (const auto &interval: intervals) {
+            if (!merged.empty() && interval.first <= merged.back().second)
+                merged.back().second = std::max(merged.back().second, interval.second);
+            else
+                merged.push_back(interval);
+        }
+        intervals.swap(merged);
+    }
+    
+    std::vector<PhaseScaling> phases = {
+        {"HalfEdge::Mesh"},
+        {"AutoRemesher::remeshUniform"},
+        {"AutoRemesher::remeshCandidate"},
+        {"AutoRemesher::parameterize"}
+    };
+    for (auto &phase: phases) {
+        double begin = std::numeric_limits<double>::max();
+        double end = std::numeric_limits<double>::lowest();
+        for (const auto &event: events) {
+            if (0 != strcmp(phase.name, event.name))
+                continue;
+            phase.busySeconds += event.durationMicroseconds / 1000000.0;
+            begin = std::min(begin, event.startMicroseconds);
+            end = std::max(end, event.startMicroseconds + event.durationMicroseconds);
+        }
+        if (begin >= end)
+            continue;
+        double busyMicroseconds = 0.0;
+        for (const auto &it: threadIntervals) {
+            for (const auto &interval: it.second)
+                busyMicroseconds += std::max(0.0, std::min(end, interval.second) - std::max(begin, interval.first));
+        }
+        phase.idleSeconds = std::max(0.0, threadCount * (end - begin) - busyMicroseconds) / 1000000.0;
+    }
+    return phases;
+}
+
+static bool saveScalingJson(const std::string &filename, const std::string &name, size_t triangleCount,
+    const std::vector<ScalingResult> &results)
+{
+    FILE *fp = fopen(filename.c_str(), "wb");
+    if (nullptr == fp)
+        return false;
+    fprintf(fp, "{\n  \"benchmark\": \"scaling\",\n  \"input\": \"%s\",\n  \"triangles\": %zu,\n  \"runs\": [\n", 
+        name.c_str(), triangleCount);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto &result = results[i];
+        double speedUp = results[0].seconds / result.seconds;
+        fprintf(fp, "    {\"threads\": %zu, \"seconds\": %.6f, \"speedUp\": %.4f, \"efficiency\": %.4f, \"phases\": [\n",
+            result.threadCount, result.seconds, speedUp, speedUp / result.threadCount);
+        for (size_t j = 0; j < result.phases.size(); ++j) {
+            const auto &phase = result.phases[j];
+            fprintf(fp, "      {\"name\": \"%s\", \"busySeconds\": %.6f, \"idleSeconds\": %.6f}%s\n",
+                phase.name, phase.busySeconds, phase.idleSeconds, j + 1 < result.phases.size() ? "," : "");
+        }
+        fprintf(fp, "    ]}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+    return 0 == fclose(fp);
+}
+
+static int runScaling(const ScalingOptions &options, const StagesOptions &corpusOptions)
+{
+    SyntheticMesh mesh;
+    std::string name = options.caseName;
+    if (!options.inputFilename.empty()) {
+        name = options.inputFilename;
+        if (!loadObj(options.inputFilename, &mesh)) {
+            std::cerr << "Load " << options.inputFilename << " failed" << std::endl;
+            return 1;
+        }
+    } else if (!makeCase(options.caseName, corpusOptions, &mesh)) {
+        std::cerr << "Unknown case: " << options.caseName << std::endl;
+        return 2;
+    }
+    printf("%s: triangles:%zu\n", name.c_str(), mesh.triangleCount());
+    
+    std::vector<size_t> threadCounts;
+    for (size_t threadCount = 1; threadCount < options.maxThreadCount; threadCount *= 2)
+        threadCounts.push_back(threadCount);
+    threadCounts.push_back(options.maxThreadCount);
+    
+    std::vector<ScalingResult> results;
+    for (const auto &threadCount: threadCounts) {
+        ScalingResult best;
+        best.threadCount = threadCount;
+        best.seconds = std::numeric_limits<double>::max();
+        tbb::task_arena arena((int)threadCount);
+        for (size_t i = 0; i < options.repeatCount; ++i) {
+            AutoRemesher::AutoRemesher autoRemesher(mesh.vertices, mesh.triangleIndices);
+            bool remeshSucceed = false;
+            AutoRemesher::Tracer::start();
+            tbb::tick_count startTime = tbb::tick_count::now();
+            arena.execute([&]() {
+                remeshSucceed = autoRemesher.remesh();
+            });
+            double seconds = (tbb::tick_count::now() - startTime).seconds();
+            AutoRemesher::Tracer::stop();
+            if (!remeshSucceed) {
+                std::cerr << "Remesh failed on " << threadCount << " threads" << std::endl;
+                return 1;
+            }
+            if (seconds < best.seconds) {
+                best.seconds = seconds;
+                best.phases = measurePhases(AutoRemesher::Tracer::events(), threadCount);
+            }
+        }
+        double speedUp = results.empty() ? 1.0 : results[0].seconds / best.seconds;
+        printf("threads:%-4zu seconds:%-9.3f speed-up:%-6.2f efficiency:%3.0f%%\n", 
+            threadCount, best.seconds, speedUp, 100.0 * speedUp / threadCount);
+        for (const auto &phase: best.phases)
+            printf("    %-32s busy:%-9.3f idle:%.3f\n", phase.name, phase.busySeconds, phase.idleSeconds);
+        results.push_back(best);
+    }
+    
+    if (!options.jsonFilename.empty() && !saveScalingJson(options.jsonFilename, name, mesh.triangleCount(), results)) {
+        std::cerr << "Save to " << options.jsonFilename << " failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+static std::vector<std::string> splitList(const std::string &list)
+{
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (std::string::npos == end)
+            end = list.size();
+        if (end > start)
+            items.push_back(list.substr(start, end - start));
+        start = end + 1;
+    }
+    return items;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string command = argc >= 2 ? argv[1] : "";
+    if ("split" != command && "stages" != command && "scaling" != command) {
+        printUsage(argv[0]);
+        return 2;
+    }
+    
+    SplitOptions splitOptions;
+    StagesOptions stagesOptions;
+    ScalingOptions scalingOptions;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            printUsage(argv[0]);
+            return 2;
+        }
+        const char *value = argv[++i];
+        if ("stages" == command) {
+            if ("--cases" == arg) {
+                stagesOptions.cases = splitList(value);
+                continue;
+            } else if ("--json" == arg) {
+                stagesOptions.jsonFilename = value;
+                continue;
+            } else if ("--write-obj" == arg) {
+                stagesOptions.objDirectory = value;
+                continue;
+            } else if ("--symmetry" == arg) {
+                stagesOptions.symmetry = value;
+                continue;
+            }
+        } else if ("scaling" == command) {
+            if ("--case" == arg) {
+                scalingOptions.caseName = value;
+                continue;
+            } else if ("--input" == arg) {
+                scalingOptions.inputFilename = value;
+                continue;
+            } else if ("--json" == arg) {
+                scalingOptions.jsonFilename = value;
+                continue;
+            }
+        }
+        size_t *target = nullptr;
+        if ("split" == command) {
+            if ("--patches" == arg)
+                target = &splitOptions.patchCount;
+            else if ("--patch-size" == arg)
+                target = &splitOptions.patchSize;
+            else if ("--repeat" == arg)
+                target = &splitOptions.repeatCount;
+        } else {
+            if ("--triangles" == arg)
+                target = &stagesOptions.triangleCount;
+            else if ("--holes" == arg)
+                target = &stagesOptions.holeCount;
+            else if ("--parts" == arg)
+                target = &stagesOptions.partCount;
+            else if ("--repeat" == arg)
+                target = "stages" == command ? &stagesOptions.repeatCount : &scalingOptions.repeatCount;
+            else if ("--max-threads" == arg && "scaling" == command)
+                target = &scalingOptions.maxThreadCount;
+            else if ("--threads" == arg && "stages" == command)
+                target = &stagesOptions.threadCount;
+        }
+        if (nullptr == target || !parseSize(value, target)) {
+            std::cerr << "Invalid option: " << arg << " " << value << std::endl;
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+    
+    if ("scaling" == command) {
+        // The arenas can only be as wide as the worker pool
+        tbb::task_scheduler_init scheduler(std::max((int)scalingOptions.maxThreadCount, 
+            tbb::task_scheduler_init::default_num_threads()));
+        return runScaling(scalingOptions, stagesOptions);
+    }
+    if ("stages" == command) {
+        tbb::task_scheduler_init scheduler((int)stagesOptions.threadCount);
+        return runStages(stagesOptions);
+    }
+    tbb::task_scheduler_init scheduler;
+    return runSplit(splitOptions);
+}
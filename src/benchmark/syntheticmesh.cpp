@@ -0,0 +1,259 @@
+/*
+ *  Copyright (c) 2020 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <limits>
+#include <algorithm>
+#include "syntheticmesh.h"
+
+using AutoRemesher::Vector3;
+
+// std::uniform_real_distribution differs between standard libraries, this doesn't
+static double randomUnit(std::mt19937 &random)
+{
+    return (double)random() / (double)std::mt19937::max();
+}
+
+void SyntheticMesh::append(const SyntheticMesh &other, const Vector3 &offset, double scale)
+{
+    uint32_t vertexStartIndex = (uint32_t)vertices.size();
+    for (const auto &it: other.vertices)
+        vertices.push_back(it * scale + offset);
+    for (const auto &it: other.triangleIndices)
+        triangleIndices.push_back(vertexStartIndex + it);
+}
+
+bool SyntheticMesh::saveObj(const std::string &filename) const
+{
+    FILE *fp = fopen(filename.c_str(), "wb");
+    if (nullptr == fp)
+        return false;
+    for (const auto &it: vertices)
+        fprintf(fp, "v %f %f %f\n", it.x(), it.y(), it.z());
+    for (size_t i = 0; i + 2 < triangleIndices.size(); i += 3)
+        fprintf(fp, "f %u %u %u\n", triangleIndices[i] + 1, triangleIndices[i + 1] + 1, triangleIndices[i + 2] + 1);
+    return 0 == fclose(fp);
+}
+
+SyntheticMesh SyntheticMesh::uvSphere(size_t targetTriangleCount)
+{
+    // Twice as many segments as rings gives 4*rings*(rings-1) triangles
+    size_t ringCount = std::max((size_t)3, (size_t)std::round(std::sqrt(targetTriangleCount / 4.0)));
+    size_t segmentCount = ringCount * 2;
+    
+    SyntheticMesh mesh;
+    mesh.vertices.push_back(Vector3(0.0, 0.0, 1.0));
+    for (size_t i = 1; i < ringCount; ++i) {
+        double theta = M_PI * i / ringCount;
+        for (size_t j = 0; j < segmentCount; ++j) {
+            double phi = 2.0 * M_PI * j / segmentCount;
+            mesh.vertices.push_back(Vector3(std::sin(theta) * std::cos(phi), 
+                std::sin(theta) * std::sin(phi), 
+                std::cos(theta)));
+        }
+    }
+    uint32_t southPole = (uint32_t)mesh.vertices.size();
+    mesh.vertices.push_back(Vector3(0.0, 0.0, -1.0));
+    
+    auto ringVertex = [&](size_t ring, size_t segment) {
+        return (uint32_t)(1 + (ring - 1) * segmentCount + segment % segmentCount);
+    };
+    for (size_t j = 0; j < segmentCount; ++j) {
+        mesh.triangleIndices.insert(mesh.triangleIndices.end(), {0, ringVertex(1, j), ringVertex(1, j + 1)});
+        for (size_t i = 1; i + 1 < ringCount; ++i) {
+            uint32_t a = ringVertex(i, j);
+            uint32_t b = ringVertex(i, j + 1);
+            uint32_t c = ringVertex(i + 1, j);
+            uint32_t d = ringVertex(i + 1, j + 1);
+            mesh.triangleIndices.insert(mesh.triangleIndices.end(), {a, c, d, a, d, b});
+        }
+        mesh.triangleIndices.insert(mesh.triangleIndices.end(), 
+            {ringVertex(ringCount - 1, j), southPole, ringVertex(ringCount - 1, j + 1)});
+    }
+    return mesh;
+}
+
+SyntheticMesh SyntheticMesh::torus(size_t targetTriangleCount)
+{
+    const double majorRadius = 1.0;
+    const double minorRadius = 0.35;
+    size_t minorCount = std::max((size_t)3, (size_t)std::round(std::sqrt(targetTriangleCount / 4.0)));
+    size_t majorCount = minorCount * 2;
+    
+    SyntheticMesh mesh;
+    for (size_t i = 0; i < majorCount; ++i) {
+        double u = 2.0 * M_PI * i / majorCount;
+        for (size_t j = 0; j < minorCount; ++j) {
+            double v = 2.0 * M_PI * j / minorCount;
+            double radius = majorRadius + minorRadius * std::cos(v);
+            mesh.vertices.push_back(Vector3(radius * std::cos(u), radius * std::sin(u), minorRadius * std::sin(v)));
+        }
+    }
+    auto gridVertex = [&](size_t i, size_t j) {
+        return (uint32_t)((i % majorCount) * minorCount + j % minorCount);
+    };
+    for (size_t i = 0; i < majorCount; ++i) {
+        for (size_t j = 0; j < minorCount; ++j) {
+            uint32_t a = gridVertex(i, j);
+            uint32_t b = gridVertex(i + 1, j);
+            uint32_t c = gridVertex(i + 1, j + 1);
+            uint32_t d = gridVertex(i, j + 1);
+            mesh.triangleIndices.insert(mesh.triangleIndices.end(), {a, b, c, a, c, d});
+        }
+    }
+    return mesh;
+}
+
+static SyntheticMesh makePerforatedPlate(size_t holeCount, size_t resolution)
+{
+    // In units of resolution: holes and the gaps around them 2 wide, the plate 1 thick
+    size_t hole = 2 * resolution;
+    size_t gap = 2 * resolution;
+    size_t size[3] = {
+        holeCount * (hole + gap) + gap,
+        hole + 2 * gap,
+        resolution
+    };
+    auto isSolid = [&](long long x, long long y, long long z) {
+        if (x < 0 || y < 0 || z < 0 || x >= (long long)size[0] || y >= (long long)size[1] || z >= (long long)size[2])
+            return false;
+        if (y >= (long long)gap && y < (long long)(gap + hole)) {
+            long long offset = x - (long long)gap;
+            if (offset >= 0 && offset % (long long)(hole + gap) < (long long)hole && 
+                    offset / (long long)(hole + gap) < (long long)holeCount)
+                return false;
+        }
+        return true;
+    };
+    
+    SyntheticMesh mesh;
+    std::vector<uint32_t> gridVertices((size[0] + 1) * (size[1] + 1) * (size[2] + 1), 
+        std::numeric_limits<uint32_t>::max());
+    auto gridVertex = [&](const long long corner[3]) {
+        uint32_t &index = gridVertices[(corner[2] * (size[1] + 1) + corner[1]) * (size[0] + 1) + corner[0]];
+        if (std::numeric_limits<uint32_t>::max() == index) {
+            index = (uint32_t)mesh.vertices.size();
+            mesh.vertices.push_back(Vector3(corner[0], corner[1], corner[2]) / (double)resolution);
+        }
+        return index;
+    };
+    
+    // A face between a solid and an empty voxel, with the corners ordered so b x c points out of the solid
+    for (long long x = 0; x < (long long)size[0]; ++x) {
+        for (long long y = 0; y < (long long)size[1]; ++y) {
+            for (long long z = 0; z < (long long)size[2]; ++z) {
+                if (!isSolid(x, y, z))
+                    continue;
+                long long voxel[3] = {x, y, z};
+                for (int axis = 0; axis < 3; ++axis) {
+                    for (int direction = -1; direction <= 1; direction += 2) {
+                        long long neighbor[3] = {x, y, z};
+                        neighbor[axis] += direction;
+                        if (isSolid(neighbor[0], neighbor[1], neighbor[2]))
+                            continue;
+                        int b = (axis + 1) % 3;
+                        int c = (axis + 2) % 3;
+                        long long corners[4][3];
+                        for (int k = 0; k < 4; ++k) {
+                            for (int i = 0; i < 3; ++i)
+                                corners[k][i] = voxel[i];
+                            corners[k][axis] += direction > 0 ? 1 : 0;
+                        }
+                        corners[1][b] += 1;
+                        corners[2][b] += 1;
+                        corners[2][c] += 1;
+                        corners[3][c] += 1;
+                        uint32_t quad[4];
+                        for (int k = 0; k < 4; ++k)
+                            quad[k] = gridVertex(corners[k]);
+                        if (direction > 0)
+                            mesh.triangleIndices.insert(mesh.triangleIndices.end(), {quad[0], quad[1], quad[2], quad[0], quad[2], quad[3]});
+                        else
+                            mesh.triangleIndices.insert(mesh.triangleIndices.end(), {quad[0], quad[2], quad[1], quad[0], quad[3], quad[2]});
+                    }
+                }
+            }
+        }
+    }
+    return mesh;
+}
+
+SyntheticMesh SyntheticMesh::perforatedPlate(size_t holeCount, size_t targetTriangleCount)
+{
+    // The face count grows with the square of the resolution
+    size_t unitTriangleCount = makePerforatedPlate(holeCount, 1).triangleCount();
+    size_t resolution = std::max((size_t)1, 
+        (size_t)std::round(std::sqrt((double)targetTriangleCount / unitTriangleCount)));
+    return makePerforatedPlate(holeCount, resolution);
+}
+
+SyntheticMesh SyntheticMesh::noisyScan(size_t targetTriangleCount, double noise, uint32_t seed)
+{
+    // The sphere is generated larger, so what is left after the bottom is cut off meets the target
+    SyntheticMesh sphere = uvSphere(targetTriangleCount * 100 / 85);
+    std::mt19937 random(seed);
+    for (auto &it: sphere.vertices)
+        it *= 1.0 + noise * (2.0 * randomUnit(random) - 1.0);
+    
+    const double cutHeight = -0.75;
+    SyntheticMesh mesh;
+    std::vector<uint32_t> oldToNew(sphere.vertices.size(), std::numeric_limits<uint32_t>::max());
+    for (size_t i = 0; i + 2 < sphere.triangleIndices.size(); i += 3) {
+        const uint32_t *face = &sphere.triangleIndices[i];
+        if (sphere.vertices[face[0]].z() < cutHeight && 
+                sphere.vertices[face[1]].z() < cutHeight && 
+                sphere.vertices[face[2]].z() < cutHeight)
+            continue;
+        for (size_t j = 0; j < 3; ++j) {
+            uint32_t &newIndex = oldToNew[face[j]];
+            if (std::numeric_limits<uint32_t>::max() == newIndex) {
+                newIndex = (uint32_t)mesh.vertices.size();
+                mesh.vertices.push_back(sphere.vertices[face[j]]);
+            }
+            mesh.triangleIndices.push_back(newIndex);
+        }
+    }
+    return mesh;
+}
+
+SyntheticMesh SyntheticMesh::assembly(size_t partCount, size_t targetTriangleCount, uint32_t seed)
+{
+    // Parts are at most 2.7 wide and placed 3.5 apart, so the jitter never makes them touch
+    const double spacing = 3.5;
+    const double jitter = 0.2;
+    size_t partTriangleCount = std::max((size_t)32, targetTriangleCount / std::max((size_t)1, partCount));
+    size_t columnCount = (size_t)std::ceil(std::sqrt((double)partCount));
+    SyntheticMesh sphere = uvSphere(partTriangleCount);
+    SyntheticMesh ring = torus(partTriangleCount);
+    
+    std::mt19937 random(seed);
+    SyntheticMesh mesh;
+    for (size_t i = 0; i < partCount; ++i) {
+        Vector3 offset((i % columnCount) * spacing + jitter * (2.0 * randomUnit(random) - 1.0),
+            (i / columnCount) * spacing + jitter * (2.0 * randomUnit(random) - 1.0),
+            jitter * (2.0 * randomUnit(random) - 1.0));
+        double scale = 0.5 + 0.5 * randomUnit(random);
+        mesh.append(0 == i % 2 ? sphere : ring, offset, scale);
+    }
+    return mesh;
+}
@@ -0,0 +1,55 @@
+/*
+ *  Copyright (c) 2020 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+#ifndef AUTO_REMESHER_SYNTHETIC_MESH_H
+#define AUTO_REMESHER_SYNTHETIC_MESH_H
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <AutoRemesher/Vector3>
+
+// Reproducible benchmark inputs, the same arguments give the same mesh on every build and platform.
+// Every generated surface is consistently oriented with outward normals
+class SyntheticMesh
+{
+public:
+    std::vector<AutoRemesher::Vector3> vertices;
+    std::vector<uint32_t> triangleIndices;
+    
+    size_t triangleCount() const
+    {
+        return triangleIndices.size() / 3;
+    }
+    
+    void append(const SyntheticMesh &other, const AutoRemesher::Vector3 &offset, double scale);
+    bool saveObj(const std::string &filename) const;
+    
+    static SyntheticMesh uvSphere(size_t targetTriangleCount);
+    static SyntheticMesh torus(size_t targetTriangleCount);
+    // A voxel slab pierced by a row of square holes, so the genus is the hole count
+    static SyntheticMesh perforatedPlate(size_t holeCount, size_t targetTriangleCount);
+    // A sphere with radial noise and an open bottom, like a turntable scan
+    static SyntheticMesh noisyScan(size_t targetTriangleCount, double noise, uint32_t seed);
+    // Disconnected spheres and tori scattered on a grid, one island each
+    static SyntheticMesh assembly(size_t partCount, size_t targetTriangleCount, uint32_t seed);
+};
+
+#endif
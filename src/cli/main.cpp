@@ -0,0 +1,482 @@
+/*
+ *  Copyright (c) 2020 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#include <tbb/partitioner.h>
+#include <tbb/task_scheduler_init.h>
+#include <tbb/tick_count.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+#include <AutoRemesher/AutoRemesher>
+#include <AutoRemesher/MemoryUsage>
+#include <AutoRemesher/Tracer>
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "../tiny_obj_loader.h"
+
+struct Options
+{
+    std::vector<std::string> inputs;
+    std::string outputDirectory;
+    double gradientSize = 0.0;
+    size_t targetVertexCount = 0;
+    size_t totalVertexCount = 0;
+    int threadCount = tbb::task_scheduler_init::automatic;
+    bool islandReport = false;
+    size_t memoryBudget = 0;
+    std::string cacheDirectory;
+    std::string traceFilename;
+    size_t tinyIslandTriangleCount = 0;
+    bool instancing = true;
+    bool speculativeCandidates = false;
+    AutoRemesher::AutoRemesher::Symmetry symmetry = AutoRemesher::AutoRemesher::Symmetry::Off;
+};
+
+struct Job
+{
+    std::string inputFilename;
+    std::string outputFilename;
+    bool succeed = false;
+    std::string message;
+    size_t inputTriangleCount = 0;
+    size_t outputQuadCount = 0;
+    size_t islandCount = 0;
+    size_t cachedIslandCount = 0;
+    size_t instancedIslandCount = 0;
+    size_t mirroredIslandCount = 0;
+    double seconds = 0.0;
+    std::vector<AutoRemesher::AutoRemesher::IslandTiming> islandTimings;
+};
+
+static void printUsage(const char *program)
+{
+    std::cerr << "Usage: " << program << " [options] <input.obj|directory>..." << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "Options:" << std::endl;
+    std::cerr << "  -o, --output-dir <dir>          Write results into <dir> instead of next to the inputs" << std::endl;
+    std::cerr << "  -g, --gradient-size <size>      Quad size, smaller gives more quads (default: " << AutoRemesher::AutoRemesher::m_defaultGradientSize << ")" << std::endl;
+    std::cerr << "  -v, --target-vertex-count <n>   Isotropic remesh vertex budget per island (default: " << AutoRemesher::AutoRemesher::m_defaultMaxVertexCount << ")" << std::endl;
+    std::cerr << "      --total-vertex-count <n>    Vertex budget of the whole model, shared out to the islands by their surface area" << std::endl;
+    std::cerr << "  -j, --threads <n>               Worker thread count (default: all cores)" << std::endl;
+    std::cerr << "  -m, --memory-budget <MB>        Only start islands while their estimated memory fits, files are then remeshed one after another" << std::endl;
+    std::cerr << "  -c, --cache-dir <dir>           Reuse the results of unchanged islands stored in <dir>" << std::endl;
+    std::cerr << "      --tiny-islands <n>          Pair the triangles of islands with fewer than <n> triangles into quads directly, skipping the full pipeline" << std::endl;
+    std::cerr << "      --no-instancing             Remesh every copy of a repeated part instead of copying the quads of the first one" << std::endl;
+    std::cerr << "      --speculative-candidates    Stop the sharp edge candidates of an island once one passes, faster but timing dependent" << std::endl;
+    std::cerr << "      --symmetry <mode>           Remesh one half of mirror symmetric islands and mirror it: detect, x, y or z (default: off)" << std::endl;
+    std::cerr << "      --island-report             Print the estimated cost and the measured time of each island" << std::endl;
+    std::cerr << "      --trace <file.json>         Write a timeline of every stage, open it in chrome://tracing or Perfetto" << std::endl;
+    std::cerr << "  -h, --help                      Show this help" << std::endl;
+}
+
+static bool parseOptions(int argc, char *argv[], Options *options)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto takeValue = [&](const char **value) {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << arg << std::endl;
+                return false;
+            }
+            *value = argv[++i];
+            return true;
+        };
+        const char *value = nullptr;
+        if ("-h" == arg || "--help" == arg) {
+            return false;
+        } else if ("-o" == arg || "--output-dir" == arg) {
+            if (!takeValue(&value))
+                return false;
+            options->outputDirectory = value;
+        } else if ("-g" == arg || "--gradient-size" == arg) {
+            if (!takeValue(&value))
+                return false;
+            options->gradientSize = std::atof(value);
+            if (options->gradientSize <= 0) {
+                std::cerr << "Invalid gradient size: " << value << std::endl;
+                return false;
+            }
+        } else if ("-v" == arg || "--target-vertex-count" == arg) {
+            if (!takeValue(&value))
+                return false;
+            long long count = std::atoll(value);
+            if (count <= 0) {
+                std::cerr << "Invalid target vertex count: " << value << std::endl;
+                return false;
+            }
+            options->targetVertexCount = (size_t)count;
+        } else if ("--total-vertex-count" == arg) {
+            if (!takeValue(&value))
+                return false;
+            long long count = std::atoll(value);
+            if (count <= 0) {
+                std::cerr << "Invalid total vertex count: " << value << std::endl;
+                return false;
+            }
+            options->totalVertexCount = (size_t)count;
+        } else if ("-j" == arg || "--threads" == arg) {
+            if (!takeValue(&value))
+                return false;
+            options->threadCount = std::atoi(value);
+            if (options->threadCount <= 0) {
+                std::cerr << "Invalid thread count: " << value << std::endl;
+                return false;
+            }
+        } else if ("-m" == arg || "--memory-budget" == arg) {
+            if (!takeValue(&value))
+                return false;
+            long long megabytes = std::atoll(value);
+            if (megabytes <= 0) {
+                std::cerr << "Invalid memory budget: " << value << std::endl;
+                return false;
+            }
+            options->memoryBudget = (size_t)megabytes * 1024 * 1024;
+        } else if ("-c" == arg || "--cache-dir" == arg) {
+            if (!takeValue(&value))
+                return false;
+            options->cacheDirectory = value;
+        } else if ("--island-report" == arg) {
+            options->islandReport = true;
+        } else if ("--no-instancing" == arg) {
+            options->instancing = false;
+        } else if ("--speculative-candidates" == arg) {
+            options->speculativeCandidates = true;
+        } else if ("--tiny-islands" == arg) {
+            if (!takeValue(&value))
+                return false;
+            long long count = std::atoll(value);
+            if (count <= 0) {
+                std::cerr << "Invalid tiny island triangle count: " << value << std::endl;
+                return false;
+            }
+            options->tinyIslandTriangleCount = (size_t)count;
+        } else if ("--symmetry" == arg) {
+            if (!takeValue(&value))
+                return false;
+            std::string mode = value;
+            if ("off" == mode) {
+                options->symmetry = AutoRemesher::AutoRemesher::Symmetry::Off;
+            } else if ("detect" == mode) {
+                options->symmetry = AutoRemesher::AutoRemesher::Symmetry::Detect;
+            } else if ("x" == mode) {
+                options->symmetry = AutoRemesher::AutoRemesher::Symmetry::X;
+            } else if ("y" == mode) {
+                options->symmetry = AutoRemesher::AutoRemesher::Symmetry::Y;
+            } else if ("z" == mode) {
+                options->symmetry = AutoRemesher::AutoRemesher::Symmetry::Z;
+            } else {
+                std::cerr << "Invalid symmetry mode: " << value << std::endl;
+                return false;
+            }
+        } else if ("--trace" == arg) {
+            if (!takeValue(&value))
+                return false;
+            options->traceFilename = value;
+        } else if (!arg.empty() && '-' == arg[0]) {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        } else {
+            options->inputs.push_back(arg);
+        }
+    }
+    if (options->inputs.empty()) {
+        std::cerr << "No input given" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static bool endsWithObj(const std::string &filename)
+{
+    if (filename.size() < 4)
+        return false;
+    std::string extension = filename.substr(filename.size() - 4);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return ".obj" == extension;
+}
+
+static bool listObjFiles(const std::string &directory, std::vector<std::string> *filenames)
+{
+    std::vector<std::string> found;
+#ifdef _WIN32
+    WIN32_FIND_DATAA findData;
+    HANDLE handle = FindFirstFileA((directory + "\\*").c_str(), &findData);
+    if (INVALID_HANDLE_VALUE == handle)
+        return false;
+    do {
+        if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            continue;
+        if (endsWithObj(findData.cFileName))
+            found.push_back(directory + "\\" + findData.cFileName);
+    } while (FindNextFileA(handle, &findData));
+    FindClose(handle);
+#else
+    DIR *dir = opendir(directory.c_str());
+    if (nullptr == dir)
+        return false;
+    while (struct dirent *entry = readdir(dir)) {
+        std::string filename = directory + "/" + entry->d_name;
+        struct stat info;
+        if (0 != stat(filename.c_str(), &info) || !S_ISREG(info.st_mode))
+            continue;
+        if (endsWithObj(entry->d_name))
+            found.push_back(filename);
+    }
+    closedir(dir);
+#endif
+    std::sort(found.begin(), found.end());
+    filenames->insert(filenames->end(), found.begin(), found.end());
+    return true;
+}
+
+static bool isDirectory(const std::string &path)
+{
+#ifdef _WIN32
+    DWORD attributes = GetFileAttributesA(path.c_str());
+    return INVALID_FILE_ATTRIBUTES != attributes && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+    struct stat info;
+    return 0 == stat(path.c_str(), &info) && S_ISDIR(info.st_mode);
+#endif
+}
+
+static std::string makeOutputFilename(const std::string &inputFilename, const std::string &outputDirectory)
+{
+    // Only an .obj extension is replaced, any other name keeps its whole self in front of the suffix
+    std::string basename = inputFilename;
+    if (basename.size() >= 4 && '.' == basename[basename.size() - 4] &&
+            'o' == std::tolower((unsigned char)basename[basename.size() - 3]) &&
+            'b' == std::tolower((unsigned char)basename[basename.size() - 2]) &&
+            'j' == std::tolower((unsigned char)basename[basename.size() - 1])) {
+        basename.resize(basename.size() - 4);
+    }
+    if (!outputDirectory.empty()) {
+        size_t slash = basename.find_last_of("/\\");
+        if (std::string::npos != slash)
+            basename = basename.substr(slash + 1);
+        basename = outputDirectory + "/" + basename;
+    }
+    return basename + "-remeshed.obj";
+}
+
+static bool loadObj(const std::string &filename, 
+    std::vector<double> *positions, 
+    std::vector<uint32_t> *triangleIndices,
+    std::string *message)
+{
+    tinyobj::attrib_t attributes;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warn, err;
+    
+    if (!tinyobj::LoadObj(&attributes, &shapes, &materials, &warn, &err, filename.c_str())) {
+        *message = err.empty() ? "Load failed" : err;
+        return false;
+    }
+    
+    positions->assign(attributes.vertices.begin(), attributes.vertices.end());
+    
+    // A face may refer to a vertex the file doesn't have, the remesher trusts every index it is given
+    size_t vertexCount = positions->size() / 3;
+    for (const auto &shape: shapes) {
+        for (const auto &index: shape.mesh.indices) {
+            if (index.vertex_index < 0 || (size_t)index.vertex_index >= vertexCount) {
+                *message = "Face refers to vertex " + std::to_string(index.vertex_index + 1) + 
+                    " of " + std::to_string(vertexCount);
+                return false;
+            }
+            triangleIndices->push_back((uint32_t)index.vertex_index);
+        }
+    }
+    if (0 != triangleIndices->size() % 3) {
+        *message = "Faces are not triangulated";
+        return false;
+    }
+    
+    return true;
+}
+
+static bool saveObj(const std::string &filename,
+    AutoRemesher::ArrayView<double> positions,
+    AutoRemesher::ArrayView<uint32_t> quadIndices)
+{
+    FILE *fp = fopen(filename.c_str(), "wb");
+    if (nullptr == fp)
+        return false;
+    fprintf(fp, "# AutoRemesher\n");
+    for (size_t i = 0; i + 2 < positions.size(); i += 3) {
+        fprintf(fp, "v %f %f %f\n", positions[i], positions[i + 1], positions[i + 2]);
+    }
+    for (size_t i = 0; i + 3 < quadIndices.size(); i += 4) {
+        fprintf(fp, "f %u %u %u %u\n", quadIndices[i] + 1, quadIndices[i + 1] + 1, 
+            quadIndices[i + 2] + 1, quadIndices[i + 3] + 1);
+    }
+    return 0 == fclose(fp);
+}
+
+static void runJob(Job *job, const Options &options)
+{
+    tbb::tick_count startTime = tbb::tick_count::now();
+    
+    std::vector<double> positions;
+    std::vector<uint32_t> triangleIndices;
+    AutoRemesher::Tracer::ScopedEvent loadEvent("loadObj");
+    if (!loadObj(job->inputFilename, &positions, &triangleIndices, &job->message))
+        return;
+    loadEvent.finish();
+    job->inputTriangleCount = triangleIndices.size() / 3;
+    
+    AutoRemesher::AutoRemesher autoRemesher(positions, triangleIndices);
+    if (options.gradientSize > 0)
+        autoRemesher.setGradientSize(options.gradientSize);
+    if (options.targetVertexCount > 0)
+        autoRemesher.setTargetVertexCount(options.targetVertexCount);
+    autoRemesher.setTotalVertexCount(options.totalVertexCount);
+    autoRemesher.setMemoryBudget(options.memoryBudget);
+    autoRemesher.setCacheDirectory(options.cacheDirectory);
+    autoRemesher.setTinyIslandTriangleCount(options.tinyIslandTriangleCount);
+    autoRemesher.setInstancing(options.instancing);
+    autoRemesher.setSpeculativeCandidates(options.speculativeCandidates);
+    autoRemesher.setSymmetry(options.symmetry);
+    if (!autoRemesher.remesh()) {
+        job->message = "Remesh failed";
+        return;
+    }
+    job->outputQuadCount = autoRemesher.remeshedQuadIndices().size() / 4;
+    job->islandTimings = autoRemesher.islandTimings();
+    job->islandCount = job->islandTimings.size();
+    job->cachedIslandCount = autoRemesher.cachedIslandCount();
+    job->instancedIslandCount = autoRemesher.instancedIslandCount();
+    job->mirroredIslandCount = autoRemesher.mirroredIslandCount();
+    
+    AutoRemesher::Tracer::ScopedEvent saveEvent("saveObj");
+    if (!saveObj(job->outputFilename, autoRemesher.remeshedPositions(), autoRemesher.remeshedQuadIndices())) {
+        job->message = "Save to " + job->outputFilename + " failed";
+        return;
+    }
+    
+    job->seconds = (tbb::tick_count::now() - startTime).seconds();
+    job->succeed = true;
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, &options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+    
+    if (!options.cacheDirectory.empty() && !isDirectory(options.cacheDirectory)) {
+        std::cerr << "Cache directory not found: " << options.cacheDirectory << std::endl;
+        return 2;
+    }
+    
+    std::vector<std::string> filenames;
+    for (const auto &input: options.inputs) {
+        if (isDirectory(input)) {
+            if (!listObjFiles(input, &filenames)) {
+                std::cerr << "Read directory failed: " << input << std::endl;
+                return 2;
+            }
+        } else {
+            filenames.push_back(input);
+        }
+    }
+    
+    std::vector<Job> jobs(filenames.size());
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        jobs[i].inputFilename = filenames[i];
+        jobs[i].outputFilename = makeOutputFilename(filenames[i], options.outputDirectory);
+    }
+    
+    tbb::task_scheduler_init scheduler(options.threadCount);
+    tbb::tick_count startTime = tbb::tick_count::now();
+    if (!options.traceFilename.empty())
+        AutoRemesher::Tracer::start();
+    
+    if (0 != options.memoryBudget) {
+        // The budget is tracked per remesh, so only one file may be in flight for it to hold
+        for (auto &job: jobs)
+            runJob(&job, options);
+    } else {
+        // Each file is a task of its own, the islands of every file are scheduled onto the same worker pool
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, jobs.size(), 1), [&](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i != range.end(); ++i)
+                runJob(&jobs[i], options);
+        }, tbb::simple_partitioner());
+    }
+    
+    if (!options.traceFilename.empty()) {
+        AutoRemesher::Tracer::stop();
+        if (!AutoRemesher::Tracer::save(options.traceFilename))
+            std::cerr << "Save trace to " << options.traceFilename << " failed" << std::endl;
+    }
+    
+    size_t failedCount = 0;
+    for (const auto &job: jobs) {
+        if (job.succeed) {
+            printf("OK     %s -> %s (triangles:%zu quads:%zu islands:%zu cached:%zu instanced:%zu mirrored:%zu seconds:%.3f)\n", 
+                job.inputFilename.c_str(),
+                job.outputFilename.c_str(),
+                job.inputTriangleCount,
+                job.outputQuadCount,
+                job.islandCount,
+                job.cachedIslandCount,
+                job.instancedIslandCount,
+                job.mirroredIslandCount,
+                job.seconds);
+            if (options.islandReport) {
+                for (const auto &timing: job.islandTimings) {
+                    printf("       island:%zu triangles:%zu estimated cost:%.0f seconds:%.3f\n",
+                        timing.islandIndex,
+                        timing.triangleCount,
+                        timing.estimatedCost,
+                        timing.seconds);
+                }
+            }
+        } else {
+            ++failedCount;
+            printf("FAILED %s (%s)\n", 
+                job.inputFilename.c_str(),
+                job.message.c_str());
+        }
+    }
+    printf("%zu succeed, %zu failed, total seconds:%.3f peak memory:%.1fMB\n", 
+        jobs.size() - failedCount, 
+        failedCount,
+        (tbb::tick_count::now() - startTime).seconds(),
+        AutoRemesher::MemoryUsage::peakResidentBytes() / (1024.0 * 1024.0));
+    
+    return 0 == failedCount ? 0 : 1;
+}
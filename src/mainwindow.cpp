@@ -69,6 +69,16 @@ void outputMessage(QtMsgType type, const QMessageLogContext &context, const QStr
         g_logBrowser->outputMessage(type, msg, context.file, context.line);
 }
 
+// The renderer still takes one index list per face
+static std::vector<std::vector<size_t>> toFaces(const std::vector<uint32_t> &indices, size_t cornerCount)
+{
+    std::vector<std::vector<size_t>> faces;
+    faces.reserve(indices.size() / cornerCount);
+    for (size_t i = 0; i + cornerCount <= indices.size(); i += cornerCount)
+        faces.push_back(std::vector<size_t>(indices.begin() + i, indices.begin() + i + cornerCount));
+    return faces;
+}
+
 size_t MainWindow::total()
 {
     return g_windows.size();
@@ -225,7 +235,7 @@ void MainWindow::updateButtonStates()
     if (nullptr == m_quadMeshGenerator &&
             !m_quadMeshResultIsDirty) {
         m_loadModelButton->showSpinner(false);
-        if (nullptr != m_remeshedQuads)
+        if (nullptr != m_remeshedQuadIndices)
             m_saveMeshButton->show();
         else
             m_saveMeshButton->hide();
@@ -263,23 +273,18 @@ bool MainWindow::loadObj(const QString &filename)
         dest.setZ(attributes.vertices[j++]);
     }
     
-    m_originalTriangles.clear();
+    m_originalTriangleIndices.clear();
     for (const auto &shape: shapes) {
-        for (size_t i = 0; i < shape.mesh.indices.size(); i += 3) {
-            m_originalTriangles.push_back(std::vector<size_t> {
-                (size_t)shape.mesh.indices[i + 0].vertex_index,
-                (size_t)shape.mesh.indices[i + 1].vertex_index,
-                (size_t)shape.mesh.indices[i + 2].vertex_index
-            });
-        }
+        for (const auto &index: shape.mesh.indices)
+            m_originalTriangleIndices.push_back((uint32_t)index.vertex_index);
     }
     
     qDebug() << "m_originalVertices.size():" << m_originalVertices.size();
-    qDebug() << "m_originalTriangles.size():" << m_originalTriangles.size();
+    qDebug() << "m_originalTriangleIndices.size():" << m_originalTriangleIndices.size();
     
     m_renderQueue.push({
         m_originalVertices,
-        m_originalTriangles
+        toFaces(m_originalTriangleIndices, 3)
     });
     checkRenderQueue();
     
@@ -333,7 +338,7 @@ void MainWindow::setCurrentFilename(const QString &filename)
 
 void MainWindow::saveMesh()
 {
-    if (nullptr == m_remeshedVertices || nullptr == m_remeshedQuads)
+    if (nullptr == m_remeshedVertices || nullptr == m_remeshedQuadIndices)
         return;
     
     QString filename = QFileDialog::getSaveFileName(this, QString(), QString(),
@@ -353,10 +358,10 @@ void MainWindow::saveMesh()
         for (std::vector<AutoRemesher::Vector3>::const_iterator it = m_remeshedVertices->begin() ; it != m_remeshedVertices->end(); ++it) {
             stream << "v " << (*it).x() << " " << (*it).y() << " " << (*it).z() << endl;
         }
-        for (std::vector<std::vector<size_t>>::const_iterator it = m_remeshedQuads->begin() ; it != m_remeshedQuads->end(); ++it) {
+        for (size_t i = 0; i + 3 < m_remeshedQuadIndices->size(); i += 4) {
             stream << "f";
-            for (std::vector<size_t>::const_iterator subIt = (*it).begin() ; subIt != (*it).end(); ++subIt) {
-                stream << " " << (1 + *subIt);
+            for (size_t j = i; j < i + 4; ++j) {
+                stream << " " << (1 + (*m_remeshedQuadIndices)[j]);
             }
             stream << endl;
         }
@@ -367,7 +372,10 @@ void MainWindow::updateTitle()
 {
     QString appName = APP_NAME;
     QString appVer = APP_HUMAN_VER;
-    setWindowTitle(QString("%1 %2 %3%4").arg(appName).arg(appVer).arg(m_currentFilename).arg(m_saved ? "" : "*"));
+    QString progress;
+    if (nullptr != m_quadMeshGenerator && !m_quadMeshResultIsDirty)
+        progress = QString(" (%1%)").arg((int)(m_quadMeshProgress * 100));
+    setWindowTitle(QString("%1 %2 %3%4%5").arg(appName).arg(appVer).arg(m_currentFilename).arg(m_saved ? "" : "*").arg(progress));
 }
 
 MainWindow::~MainWindow()
@@ -527,11 +535,15 @@ void MainWindow::renderMeshReady()
 void MainWindow::generateQuadMesh()
 {
     if (nullptr != m_quadMeshGenerator) {
+        // The running result is superseded, stop it instead of waiting for it to finish
         m_quadMeshResultIsDirty = true;
+        m_quadMeshGenerator->cancel();
+        updateTitle();
         return;
     }
     
     m_quadMeshResultIsDirty = false;
+    m_quadMeshProgress = 0.0;
     m_saved = true;
     m_inProgress = true;
     
@@ -541,11 +553,12 @@ void MainWindow::generateQuadMesh()
     if (!m_highPoly)
         parameters.gradientSize = 100.0;
     
-    m_quadMeshGenerator = new QuadMeshGenerator(m_originalVertices, m_originalTriangles);
+    m_quadMeshGenerator = new QuadMeshGenerator(m_originalVertices, m_originalTriangleIndices);
     m_quadMeshGenerator->setParameters(parameters);
     m_quadMeshGenerator->moveToThread(thread);
     connect(thread, &QThread::started, m_quadMeshGenerator, &QuadMeshGenerator::process);
     connect(m_quadMeshGenerator, &QuadMeshGenerator::finished, this, &MainWindow::quadMeshReady);
+    connect(m_quadMeshGenerator, &QuadMeshGenerator::progressChanged, this, &MainWindow::quadMeshProgressChanged);
     connect(m_quadMeshGenerator, &QuadMeshGenerator::finished, thread, &QThread::quit);
     connect(thread, &QThread::finished, thread, &QThread::deleteLater);
     thread->start();
@@ -559,8 +572,8 @@ void MainWindow::quadMeshReady()
     delete m_remeshedVertices;
     m_remeshedVertices = m_quadMeshGenerator->takeRemeshedVertices();
     
-    delete m_remeshedQuads;
-    m_remeshedQuads = m_quadMeshGenerator->takeRemeshedQuads();
+    delete m_remeshedQuadIndices;
+    m_remeshedQuadIndices = m_quadMeshGenerator->takeRemeshedQuadIndices();
     
     m_saved = false;
     m_inProgress = false;
@@ -568,10 +581,15 @@ void MainWindow::quadMeshReady()
     delete m_quadMeshGenerator;
     m_quadMeshGenerator = nullptr;
     
-    if (nullptr != m_remeshedVertices && nullptr != m_remeshedQuads) {
+    if (m_quadMeshResultIsDirty) {
+        generateQuadMesh();
+        return;
+    }
+    
+    if (nullptr != m_remeshedVertices && nullptr != m_remeshedQuadIndices) {
         m_renderQueue.push({
             *m_remeshedVertices,
-            *m_remeshedQuads
+            toFaces(*m_remeshedQuadIndices, 4)
         });
         checkRenderQueue();
     } else {
@@ -582,9 +600,12 @@ void MainWindow::quadMeshReady()
         checkRenderQueue();
     }
     
-    if (m_quadMeshResultIsDirty)
-        generateQuadMesh();
-    
     updateButtonStates();
     updateTitle();
 }
+
+void MainWindow::quadMeshProgressChanged(double progress)
+{
+    m_quadMeshProgress = progress;
+    updateTitle();
+}
@@ -66,6 +66,7 @@ private slots:
     void renderMeshReady();
     void generateQuadMesh();
     void quadMeshReady();
+    void quadMeshProgressChanged(double progress);
     void updateButtonStates();
 private:
     PbrShaderWidget *m_modelRenderWidget = nullptr;
@@ -73,13 +74,14 @@ private:
     bool m_inProgress = false;
     bool m_saved = true;
     std::vector<AutoRemesher::Vector3> m_originalVertices;
-    std::vector<std::vector<size_t>> m_originalTriangles;
+    std::vector<uint32_t> m_originalTriangleIndices;
     std::vector<AutoRemesher::Vector3> *m_remeshedVertices = nullptr;
-    std::vector<std::vector<size_t>> *m_remeshedQuads = nullptr;
+    std::vector<uint32_t> *m_remeshedQuadIndices = nullptr;
     QString m_currentFilename;
     RenderMeshGenerator *m_renderMeshGenerator = nullptr;
     std::queue<ResultMesh> m_renderQueue;
     bool m_quadMeshResultIsDirty = false;
+    double m_quadMeshProgress = 0.0;
     bool m_highPoly = false;
     QuadMeshGenerator *m_quadMeshGenerator = nullptr;
     SpinnableAwesomeButton *m_loadModelButton = nullptr;
@@ -21,6 +21,7 @@
  */
 #include <QElapsedTimer>
 #include <QDebug>
+#include <cmath>
 #include "quadmeshgenerator.h"
 
 void QuadMeshGenerator::process()
@@ -39,15 +40,25 @@ void QuadMeshGenerator::process()
 void QuadMeshGenerator::generate()
 {
     delete m_autoRemesher;
-    m_autoRemesher = new AutoRemesher::AutoRemesher(m_vertices, m_triangles);
+    m_autoRemesher = new AutoRemesher::AutoRemesher(m_vertices, m_triangleIndices);
     if (m_parameters.gradientSize > 0)
         m_autoRemesher->setGradientSize(m_parameters.gradientSize);
+    m_autoRemesher->setCancelToken(&m_cancelled);
+    // Every island step reports, only a visible change crosses the thread to the progress bar.
+    // The callbacks come in one at a time, under the remesher's progress lock
+    m_lastReportedProgress = -1.0;
+    m_autoRemesher->setProgressCallback([=](AutoRemesher::AutoRemesher::Stage, size_t, double fraction) {
+        if (std::abs(fraction - m_lastReportedProgress) < 0.01 && fraction < 1.0)
+            return;
+        m_lastReportedProgress = fraction;
+        emit progressChanged(fraction);
+    });
     if (!m_autoRemesher->remesh())
         return;
     
     delete m_remeshedVertices;
     m_remeshedVertices = new std::vector<AutoRemesher::Vector3>(m_autoRemesher->remeshedVertices());
     
-    delete m_remeshedQuads;
-    m_remeshedQuads = new std::vector<std::vector<size_t>>(m_autoRemesher->remeshedQuads());
+    delete m_remeshedQuadIndices;
+    m_remeshedQuadIndices = new std::vector<uint32_t>(m_autoRemesher->remeshedQuadIndices());
 }
@@ -22,6 +22,7 @@
 #ifndef AUTO_REMESHER_QUAD_MESH_GENERATOR_H
 #define AUTO_REMESHER_QUAD_MESH_GENERATOR_H
 #include <QObject>
+#include <atomic>
 #include <AutoRemesher/AutoRemesher>
 
 class QuadMeshGenerator: public QObject
@@ -34,16 +35,16 @@ public:
     };
 
     QuadMeshGenerator(const std::vector<AutoRemesher::Vector3> &vertices,
-            const std::vector<std::vector<size_t>> &triangles) :
+            const std::vector<uint32_t> &triangleIndices) :
         m_vertices(vertices),
-        m_triangles(triangles)
+        m_triangleIndices(triangleIndices)
     {
     }
     
     ~QuadMeshGenerator()
     {
         delete m_remeshedVertices;
-        delete m_remeshedQuads;
+        delete m_remeshedQuadIndices;
         delete m_autoRemesher;
     }
     
@@ -59,27 +60,36 @@ public:
         return remeshedVertices;
     }
     
-    std::vector<std::vector<size_t>> *takeRemeshedQuads()
+    std::vector<uint32_t> *takeRemeshedQuadIndices()
     {
-        std::vector<std::vector<size_t>> *remeshedQuads = m_remeshedQuads;
-        m_remeshedQuads = nullptr;
-        return remeshedQuads;
+        std::vector<uint32_t> *remeshedQuadIndices = m_remeshedQuadIndices;
+        m_remeshedQuadIndices = nullptr;
+        return remeshedQuadIndices;
+    }
+
+    // Safe to call from any thread, the running remesh stops soon after and no result is produced
+    void cancel()
+    {
+        m_cancelled = true;
     }
 
     void generate();
     
 signals:
     void finished();
+    void progressChanged(double progress);
 public slots:
     void process();
     
 private:
     std::vector<AutoRemesher::Vector3> m_vertices;
-    std::vector<std::vector<size_t>> m_triangles;
+    std::vector<uint32_t> m_triangleIndices;
     std::vector<AutoRemesher::Vector3> *m_remeshedVertices = nullptr;
-    std::vector<std::vector<size_t>> *m_remeshedQuads = nullptr;
+    std::vector<uint32_t> *m_remeshedQuadIndices = nullptr;
     AutoRemesher::AutoRemesher *m_autoRemesher = nullptr;
     Parameters m_parameters;
+    std::atomic<bool> m_cancelled{false};
+    double m_lastReportedProgress = -1.0;
 };
 
 #endif
@@ -146,7 +146,10 @@ public:
   // The i-th row contains the indices of the vertices that forms the i-th face in ccw order
   Eigen::MatrixXi faces;
 
-  std::vector<std::vector<int> > vertex_to_vertices;
+  // Vertex adjacency in compressed rows, the neighbours of vertex i are vertex_neighbors
+  // from vertex_neighbor_offsets[i] up to vertex_neighbor_offsets[i+1], in ascending order
+  std::vector<int> vertex_neighbor_offsets;
+  std::vector<int> vertex_neighbors;
   std::vector<std::vector<int> > vertex_to_faces;
   std::vector<std::vector<int> > vertex_to_faces_index;
   Eigen::MatrixXd face_normals;
@@ -175,6 +178,12 @@ public:
 
   IGL_INLINE CurvatureCalculator();
   IGL_INLINE void init(const Eigen::MatrixXd& V, const Eigen::MatrixXi& F);
+  template <typename AdjacencyIndex>
+  IGL_INLINE void init(const Eigen::MatrixXd& V, const Eigen::MatrixXi& F,
+    const std::vector<AdjacencyIndex>& adjacency_offsets,
+    const std::vector<AdjacencyIndex>& adjacency_neighbors);
+  IGL_INLINE static void adjacencyRows(const Eigen::MatrixXi& F, int vertexCount,
+    std::vector<int>& offsets, std::vector<int>& neighbors);
 
   IGL_INLINE void finalEigenStuff(int, const std::vector<Eigen::Vector3d>&, Quadric&);
   IGL_INLINE void fitQuadric(const Eigen::Vector3d&, const std::vector<Eigen::Vector3d>& ref, const std::vector<int>& , Quadric *);
@@ -190,6 +199,15 @@ public:
   IGL_INLINE void printCurvature(const std::string& outpath);
   IGL_INLINE double getAverageEdge();
 
+private:
+  /* Marks the vertices gathered for the current one, bumping the stamp clears all the marks */
+  std::vector<int> visited;
+  int visitStamp;
+
+  IGL_INLINE void initGeometry(const Eigen::MatrixXd& V, const Eigen::MatrixXi& F);
+
+public:
+
   IGL_INLINE static int rotateForward (double *v0, double *v1, double *v2)
   {
     double t;
@@ -313,9 +331,16 @@ IGL_INLINE CurvatureCalculator::CurvatureCalculator()
   this->kRing=3;
   this->curvatureComputed=false;
   this->expStep=true;
+  this->visitStamp=0;
 }
 
 IGL_INLINE void CurvatureCalculator::init(const Eigen::MatrixXd& V, const Eigen::MatrixXi& F)
+{
+  adjacencyRows(F, V.rows(), vertex_neighbor_offsets, vertex_neighbors);
+  initGeometry(V, F);
+}
+
+IGL_INLINE void CurvatureCalculator::initGeometry(const Eigen::MatrixXd& V, const Eigen::MatrixXi& F)
 {
   // Normalize vertices
   vertices = V;
@@ -325,12 +350,36 @@ IGL_INLINE void CurvatureCalculator::init(const Eigen::MatrixXd& V, const Eigen:
 //  vertices = vertices.array() * (1.0/igl::avg_edge_length(V,F));
 
   faces = F;
-  igl::adjacency_list(F, vertex_to_vertices);
+  visited.assign(V.rows(), 0);
+  visitStamp = 0;
   igl::vertex_triangle_adjacency(V, F, vertex_to_faces, vertex_to_faces_index);
   igl::per_face_normals(V, F, face_normals);
   igl::per_vertex_normals(V, F, face_normals, vertex_normals);
 }
 
+template <typename AdjacencyIndex>
+IGL_INLINE void CurvatureCalculator::init(const Eigen::MatrixXd& V, const Eigen::MatrixXi& F,
+  const std::vector<AdjacencyIndex>& adjacency_offsets,
+  const std::vector<AdjacencyIndex>& adjacency_neighbors)
+{
+  vertex_neighbor_offsets.assign(adjacency_offsets.begin(), adjacency_offsets.end());
+  vertex_neighbors.assign(adjacency_neighbors.begin(), adjacency_neighbors.end());
+  initGeometry(V, F);
+}
+
+IGL_INLINE void CurvatureCalculator::adjacencyRows(const Eigen::MatrixXi& F, int vertexCount,
+  std::vector<int>& offsets, std::vector<int>& neighbors)
+{
+  std::vector<std::vector<int> > lists;
+  igl::adjacency_list(F, lists);
+  offsets.assign(vertexCount + 1, 0);
+  for (int i=0; i<vertexCount; ++i)
+    offsets[i+1] = offsets[i] + (i < (int)lists.size() ? (int)lists[i].size() : 0);
+  neighbors.resize(offsets.back());
+  for (int i=0; i<(int)lists.size() && i<vertexCount; ++i)
+    std::copy(lists[i].begin(), lists[i].end(), neighbors.begin() + offsets[i]);
+}
+
 IGL_INLINE void CurvatureCalculator::fitQuadric(const Eigen::Vector3d& v, const std::vector<Eigen::Vector3d>& ref, const std::vector<int>& vv, Quadric *q)
 {
   std::vector<Eigen::Vector3d> points;
@@ -445,27 +494,26 @@ IGL_INLINE void CurvatureCalculator::finalEigenStuff(int i, const std::vector<Ei
 
 IGL_INLINE void CurvatureCalculator::getKRing(const int start, const double r, std::vector<int>&vv)
 {
-  int bufsize=vertices.rows();
-  vv.reserve(bufsize);
-  std::list<std::pair<int,int> > queue;
-  std::vector<bool> visited(bufsize, false);
-  queue.push_back(std::pair<int,int>(start,0));
-  visited[start]=true;
-  while (!queue.empty())
+  // Breadth first, vv itself is the queue and distances holds the ring of each entry
+  ++visitStamp;
+  std::vector<int> distances;
+  vv.push_back(start);
+  distances.push_back(0);
+  visited[start]=visitStamp;
+  for (size_t head=0; head<vv.size(); ++head)
   {
-    int toVisit=queue.front().first;
-    int distance=queue.front().second;
-    queue.pop_front();
-    vv.push_back(toVisit);
+    int toVisit=vv[head];
+    int distance=distances[head];
     if (distance<(int)r)
     {
-      for (unsigned int i=0; i<vertex_to_vertices[toVisit].size(); ++i)
+      for (int i=vertex_neighbor_offsets[toVisit]; i<vertex_neighbor_offsets[toVisit+1]; ++i)
       {
-        int neighbor=vertex_to_vertices[toVisit][i];
-        if (!visited[neighbor])
+        int neighbor=vertex_neighbors[i];
+        if (visited[neighbor]!=visitStamp)
         {
-          queue.push_back(std::pair<int,int> (neighbor,distance+1));
-          visited[neighbor]=true;
+          vv.push_back(neighbor);
+          distances.push_back(distance+1);
+          visited[neighbor]=visitStamp;
         }
       }
     }
@@ -475,31 +523,27 @@ IGL_INLINE void CurvatureCalculator::getKRing(const int start, const double r, s
 
 IGL_INLINE void CurvatureCalculator::getSphere(const int start, const double r, std::vector<int> &vv, int min)
 {
-  int bufsize=vertices.rows();
-  vv.reserve(bufsize);
-  std::list<int> queue;
-  std::vector<bool> visited(bufsize, false);
-  queue.push_back(start);
-  visited[start]=true;
+  // Breadth first, the vertices before head in vv have been visited, the rest are queued
+  ++visitStamp;
+  vv.push_back(start);
+  visited[start]=visitStamp;
   Eigen::Vector3d me=vertices.row(start);
   std::priority_queue<std::pair<int, double>, std::vector<std::pair<int, double> >, comparer > extra_candidates;
-  while (!queue.empty())
+  for (size_t head=0; head<vv.size(); ++head)
   {
-    int toVisit=queue.front();
-    queue.pop_front();
-    vv.push_back(toVisit);
-    for (unsigned int i=0; i<vertex_to_vertices[toVisit].size(); ++i)
+    int toVisit=vv[head];
+    for (int i=vertex_neighbor_offsets[toVisit]; i<vertex_neighbor_offsets[toVisit+1]; ++i)
     {
-      int neighbor=vertex_to_vertices[toVisit][i];
-      if (!visited[neighbor])
+      int neighbor=vertex_neighbors[i];
+      if (visited[neighbor]!=visitStamp)
       {
         Eigen::Vector3d neigh=vertices.row(neighbor);
         double distance=(me-neigh).norm();
         if (distance<r)
-          queue.push_back(neighbor);
-        else if ((int)vv.size()<min)
+          vv.push_back(neighbor);
+        else if ((int)head+1<min)
           extra_candidates.push(std::pair<int,double>(neighbor,distance));
-        visited[neighbor]=true;
+        visited[neighbor]=visitStamp;
       }
     }
   }
@@ -508,15 +552,15 @@ IGL_INLINE void CurvatureCalculator::getSphere(const int start, const double r,
     std::pair<int, double> cand=extra_candidates.top();
     extra_candidates.pop();
     vv.push_back(cand.first);
-    for (unsigned int i=0; i<vertex_to_vertices[cand.first].size(); ++i)
+    for (int i=vertex_neighbor_offsets[cand.first]; i<vertex_neighbor_offsets[cand.first+1]; ++i)
     {
-      int neighbor=vertex_to_vertices[cand.first][i];
-      if (!visited[neighbor])
+      int neighbor=vertex_neighbors[i];
+      if (visited[neighbor]!=visitStamp)
       {
         Eigen::Vector3d neigh=vertices.row(neighbor);
         double distance=(me-neigh).norm();
         extra_candidates.push(std::pair<int,double>(neighbor,distance));
-        visited[neighbor]=true;
+        visited[neighbor]=visitStamp;
       }
     }
   }
@@ -530,7 +574,7 @@ IGL_INLINE Eigen::Vector3d CurvatureCalculator::project(const Eigen::Vector3d& v
 IGL_INLINE void CurvatureCalculator::computeReferenceFrame(int i, const Eigen::Vector3d& normal, std::vector<Eigen::Vector3d>& ref )
 {
 
-  Eigen::Vector3d longest_v=Eigen::Vector3d(vertices.row(vertex_to_vertices[i][0]));
+  Eigen::Vector3d longest_v=Eigen::Vector3d(vertices.row(vertex_neighbors[vertex_neighbor_offsets[i]]));
 
   longest_v=(project(vertices.row(i),longest_v,normal)-Eigen::Vector3d(vertices.row(i))).normalized();
 
@@ -870,6 +914,32 @@ IGL_INLINE void igl::principal_curvature(
   Eigen::PlainObjectBase<DerivedPV2>& PV2,
   unsigned radius,
   bool useKring)
+{
+  std::vector<int> adjacency_offsets;
+  std::vector<int> adjacency_neighbors;
+  CurvatureCalculator::adjacencyRows(F.template cast<int>(), V.rows(), adjacency_offsets, adjacency_neighbors);
+  principal_curvature(V, F, adjacency_offsets, adjacency_neighbors, PD1, PD2, PV1, PV2, radius, useKring);
+}
+
+template <
+  typename DerivedV,
+  typename DerivedF,
+  typename AdjacencyIndex,
+  typename DerivedPD1,
+  typename DerivedPD2,
+  typename DerivedPV1,
+  typename DerivedPV2>
+IGL_INLINE void igl::principal_curvature(
+  const Eigen::PlainObjectBase<DerivedV>& V,
+  const Eigen::PlainObjectBase<DerivedF>& F,
+  const std::vector<AdjacencyIndex>& adjacency_offsets,
+  const std::vector<AdjacencyIndex>& adjacency_neighbors,
+  Eigen::PlainObjectBase<DerivedPD1>& PD1,
+  Eigen::PlainObjectBase<DerivedPD2>& PD2,
+  Eigen::PlainObjectBase<DerivedPV1>& PV1,
+  Eigen::PlainObjectBase<DerivedPV2>& PV2,
+  unsigned radius,
+  bool useKring)
 {
   if (radius < 2)
   {
@@ -887,7 +957,7 @@ IGL_INLINE void igl::principal_curvature(
 
   // Precomputation
   CurvatureCalculator cc;
-  cc.init(V.template cast<double>(),F.template cast<int>());
+  cc.init(V.template cast<double>(),F.template cast<int>(),adjacency_offsets,adjacency_neighbors);
   cc.sphereRadius = radius;
 
   if (useKring)
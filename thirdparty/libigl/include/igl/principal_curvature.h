@@ -64,6 +64,32 @@ IGL_INLINE void principal_curvature(
   unsigned radius = 5,
   bool useKring = true);
 
+  // As above, with the vertex adjacency given in compressed rows instead of being rebuilt from F
+  // Inputs:
+  //   adjacency_offsets  #V+1 list, the neighbours of vertex i run from adjacency_offsets(i)
+  //     up to adjacency_offsets(i+1) in adjacency_neighbors
+  //   adjacency_neighbors  neighbouring vertex indices, ascending within each vertex as
+  //     adjacency_list gives them
+template <
+  typename DerivedV,
+  typename DerivedF,
+  typename AdjacencyIndex,
+  typename DerivedPD1,
+  typename DerivedPD2,
+  typename DerivedPV1,
+  typename DerivedPV2>
+IGL_INLINE void principal_curvature(
+  const Eigen::PlainObjectBase<DerivedV>& V,
+  const Eigen::PlainObjectBase<DerivedF>& F,
+  const std::vector<AdjacencyIndex>& adjacency_offsets,
+  const std::vector<AdjacencyIndex>& adjacency_neighbors,
+  Eigen::PlainObjectBase<DerivedPD1>& PD1,
+  Eigen::PlainObjectBase<DerivedPD2>& PD2,
+  Eigen::PlainObjectBase<DerivedPV1>& PV1,
+  Eigen::PlainObjectBase<DerivedPV2>& PV2,
+  unsigned radius = 5,
+  bool useKring = true);
+
 template <
   typename DerivedV,
   typename DerivedF,